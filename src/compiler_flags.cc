@@ -0,0 +1,419 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "precompiled.h"
+#include "compiler_flags.h"
+#include "utility.h"
+
+#include <ctype.h>
+
+using std::string;
+using std::vector;
+
+typedef vs::VCCLCompilerTool::Enum CL;
+
+// Each row adds its flags when the property is set to the value,
+// optimized rows only when Optimization isn't disabled. Rows are
+// in command line order, for GCC the last -O wins so favoring size
+// overrides the optimization level.
+//
+// /Ox has no GCC equivalent beyond -O2. MSVC's defaults for /GR and
+// /EHsc match GCC's so only turning them off adds a flag. /EHa also
+// catches asynchronous exceptions, -fnon-call-exceptions is closest.
+#define CODE_GENERATION_FLAGS \
+X(Optimization,                 CL::optimizeDisabled,                 false, "-O0")\
+X(Optimization,                 CL::optimizeMinSpace,                 false, "-Os")\
+X(Optimization,                 CL::optimizeMaxSpeed,                 false, "-O2")\
+X(Optimization,                 CL::optimizeFull,                     false, "-O2")\
+X(FavorSizeOrSpeed,             CL::favorSize,                        true,  "-Os")\
+X(InlineFunctionExpansion,      CL::expandDisable,                    true,  "-fno-inline")\
+X(InlineFunctionExpansion,      CL::expandOnlyInline,                 true,  "-fno-inline-functions")\
+X(InlineFunctionExpansion,      CL::expandAnySuitable,                true,  "-finline-functions")\
+X(EnableIntrinsicFunctions,     true,                                 false, "-fbuiltin")\
+X(OmitFramePointers,            true,                                 true,  "-fomit-frame-pointer")\
+X(OmitFramePointers,            false,                                true,  "-fno-omit-frame-pointer")\
+X(StringPooling,                true,                                 false, "-fmerge-constants")\
+X(FloatingPointModel,           CL::FloatingPointStrict,              false, "-frounding-math -fsignaling-nans -ffp-contract=off")\
+X(FloatingPointModel,           CL::FloatingPointFast,                false, "-ffast-math")\
+X(EnableEnhancedInstructionSet, CL::enhancedInstructionSetTypeSIMD,   false, "-msse")\
+X(EnableEnhancedInstructionSet, CL::enhancedInstructionSetTypeSIMD2,  false, "-msse2")\
+X(OpenMP,                       true,                                 false, "-fopenmp")\
+X(BufferSecurityCheck,          true,                                 false, "-fstack-protector-strong")\
+X(BufferSecurityCheck,          false,                                false, "-fno-stack-protector")\
+X(RuntimeTypeInfo,              false,                                false, "-fno-rtti")\
+X(ExceptionHandling,            CL::cppExceptionHandlingNo,           false, "-fno-exceptions")\
+X(ExceptionHandling,            CL::cppExceptionHandlingYesWithSEH,   false, "-fnon-call-exceptions")
+
+string CodeGenerationFlags(const vs::VCCLCompilerTool& cl) {
+  bool optimized = cl.HasProperty("Optimization") && cl.Optimization() != CL::optimizeDisabled;
+
+  string flags;
+#define X(NAME, VALUE, OPTIMIZED, FLAGS)                                      \
+  if(cl.HasProperty(#NAME) && cl.NAME() == VALUE && (optimized || !OPTIMIZED)) { \
+    flags.append(flags.empty() ? "" : " ").append(FLAGS);                       \
+  }
+  CODE_GENERATION_FLAGS
+#undef X
+  return flags;
+}
+
+bool LinkTimeOptimization(const vs::Configuration& config) {
+  if(config.WholeProgramOptimization != vs::Enum::Optimization_None) return true;
+  if(config.CLCompilerTool.WholeProgramOptimization()) return true;
+
+  vs::VCLinkerTool::Enum ltcg = config.LinkerTool.LinkTimeCodeGeneration();
+  return ltcg != vs::VCLinkerTool::Enum_Unknown &&
+         ltcg != vs::VCLinkerTool::Enum_LinkTimeCodeGenerationOptionDefault;
+}
+
+namespace {
+
+struct OptionFlags {
+  const char* option;
+  const char* flags;
+};
+
+// MSVC compiler switches, case sensitive. Switches the build already
+// covers or that don't change the generated code translate to nothing.
+const OptionFlags kCompilerOptions[] = {
+  {"/O1",           "-Os"},
+  {"/O2",           "-O2"},
+  {"/Ox",           "-O2"},
+  {"/Od",           "-O0"},
+  {"/Os",           "-Os"},
+  {"/Ot",           ""},
+  {"/Oi",           "-fbuiltin"},
+  {"/Oi-",          "-fno-builtin"},
+  {"/Oy",           "-fomit-frame-pointer"},
+  {"/Oy-",          "-fno-omit-frame-pointer"},
+  {"/Ob0",          "-fno-inline"},
+  {"/Ob1",          "-fno-inline-functions"},
+  {"/Ob2",          "-finline-functions"},
+  {"/Ob3",          "-finline-functions"},
+  {"/GL",           "-flto"},
+  {"/GL-",          ""},
+  {"/Gy",           "-ffunction-sections"},
+  {"/Gy-",          ""},
+  {"/Gw",           "-fdata-sections"},
+  {"/Gw-",          ""},
+  {"/GF",           "-fmerge-constants"},
+  {"/GS",           "-fstack-protector-strong"},
+  {"/GS-",          "-fno-stack-protector"},
+  {"/GR",           "-frtti"},
+  {"/GR-",          "-fno-rtti"},
+  {"/EHs",          "-fexceptions"},
+  {"/EHsc",         "-fexceptions"},
+  {"/EHa",          "-fnon-call-exceptions"},
+  {"/fp:precise",   ""},
+  {"/fp:strict",    "-frounding-math -fsignaling-nans -ffp-contract=off"},
+  {"/fp:fast",      "-ffast-math"},
+  {"/arch:IA32",    ""},
+  {"/arch:SSE",     "-msse"},
+  {"/arch:SSE2",    "-msse2"},
+  {"/arch:AVX",     "-mavx"},
+  {"/arch:AVX2",    "-mavx2 -mfma"},
+  {"/arch:AVX512",  "-mavx512f -mavx512cd -mavx512bw -mavx512dq -mavx512vl"},
+  {"/openmp",       "-fopenmp"},
+  {"/openmp:llvm",  "-fopenmp"},
+  {"/std:c++14",    "-std=c++14"},
+  {"/std:c++17",    "-std=c++17"},
+  {"/std:c++20",    "-std=c++20"},
+  {"/utf-8",        "-finput-charset=UTF-8 -fexec-charset=UTF-8"},
+  {"/Z7",           "-g"},
+  {"/Zi",           "-g"},
+  {"/ZI",           "-g"},
+  {"/W0",           "-w"},
+  {"/W1",           ""},
+  {"/W2",           ""},
+  {"/W3",           ""},
+  {"/W4",           ""},
+  {"/WX",           "-Werror"},
+  {"/MP",           ""},
+  {"/bigobj",       ""},
+  {"/nologo",       ""},
+  {"/permissive-",  ""},
+};
+
+// Compiler switches whose suffix is ignored
+const char* const kIgnoredCompilerPrefixes[] = {
+  "/MP", "/Zc:", "/wd", "/we", "/wo", "/Zm", "/FS", "/errorReport:",
+};
+
+// MSVC linker switches, compared in upper case
+const OptionFlags kLinkerOptions[] = {
+  {"/LTCG",               "-flto"},
+  {"/OPT:REF",            "-Wl,--gc-sections"},
+  {"/OPT:NOREF",          ""},
+  {"/OPT:ICF",            ""},
+  {"/OPT:NOICF",          ""},
+  {"/OPT:LBR",            ""},
+  {"/DEBUG",              "-g"},
+  {"/INCREMENTAL",        ""},
+  {"/INCREMENTAL:NO",     ""},
+  {"/NOLOGO",             ""},
+  {"/DYNAMICBASE",        ""},
+  {"/DYNAMICBASE:NO",     ""},
+  {"/NXCOMPAT",           ""},
+  {"/NXCOMPAT:NO",        ""},
+  {"/LARGEADDRESSAWARE",  ""},
+  {"/SAFESEH",            ""},
+  {"/SAFESEH:NO",         ""},
+};
+
+// Linker switches whose suffix is ignored, in upper case
+const char* const kIgnoredLinkerPrefixes[] = {
+  "/LTCG:", "/DEBUG:", "/SUBSYSTEM:", "/MACHINE:", "/MANIFEST", "/PDB:",
+  "/IGNORE:", "/ERRORREPORT:", "/TLBID:",
+};
+
+// Windows libraries the default .lib list links, with no use elsewhere
+const char* const kWindowsLibraries[] = {
+  "KERNEL32.LIB", "USER32.LIB", "GDI32.LIB", "WINSPOOL.LIB", "COMDLG32.LIB",
+  "ADVAPI32.LIB", "SHELL32.LIB", "OLE32.LIB", "OLEAUT32.LIB", "UUID.LIB",
+  "ODBC32.LIB", "ODBCCP32.LIB", "WS2_32.LIB", "WINMM.LIB",
+};
+
+bool StartsWith(const string& s, const char* prefix) {
+  return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+bool EndsWith(const string& s, const char* suffix) {
+  size_t length = strlen(suffix);
+  return s.size() >= length && s.compare(s.size() - length, length, suffix) == 0;
+}
+
+string ToUpper(string s) {
+  for(size_t i = 0; i < s.size(); ++i) {
+    s[i] = static_cast<char>(toupper(static_cast<unsigned char>(s[i])));
+  }
+  return s;
+}
+
+// Flags with whitespace stay one word on the shell command line
+string Quote(const string& flag) {
+  return flag.find_first_of(" \t") == string::npos ? flag : "\"" + flag + "\"";
+}
+
+void Split(const string& options, bool keep_quotes, vector<string>* tokens) {
+  string token;
+  bool quoted = false;
+  bool pending = false;
+  for(size_t i = 0; i < options.size(); ++i) {
+    char c = options[i];
+    if(c == '"') {
+      quoted = !quoted;
+      pending = true;
+      if(keep_quotes) token.push_back(c);
+    } else if(!quoted && isspace(static_cast<unsigned char>(c))) {
+      if(pending) tokens->push_back(token);
+      token.clear();
+      pending = false;
+    } else {
+      token.push_back(c);
+      pending = true;
+    }
+  }
+  if(pending) tokens->push_back(token);
+}
+
+// GCC flags that take their argument as the next word
+const char* const kSeparateArguments[] = {
+  "-include", "-imacros", "-isystem", "-idirafter", "-iquote", "-x", "-Xlinker",
+  "-Xassembler", "-Xpreprocessor", "-MF", "-MT", "-MQ", "-D", "-U", "-I", "-L", "-l", "-o",
+};
+
+// Splits flags into whole flags, each flag of kSeparateArguments
+// together with its argument.
+void SplitFlags(const string& flags, vector<string>* words) {
+  vector<string> tokens;
+  Split(flags, true, &tokens);
+  for(size_t i = 0; i < tokens.size(); ++i) {
+    words->push_back(tokens[i]);
+    if(i + 1 < tokens.size() &&
+       std::find(kSeparateArguments, kSeparateArguments + ARRAY_COUNT(kSeparateArguments),
+                 tokens[i]) != kSeparateArguments + ARRAY_COUNT(kSeparateArguments)) {
+      words->back().append(" ").append(tokens[++i]);
+    }
+  }
+}
+
+const char* Find(const OptionFlags* table, size_t count, const string& option) {
+  for(size_t i = 0; i < count; ++i) {
+    if(option == table[i].option) return table[i].flags;
+  }
+  return 0;
+}
+
+bool Ignored(const char* const* prefixes, size_t count, const string& option) {
+  for(size_t i = 0; i < count; ++i) {
+    if(StartsWith(option, prefixes[i])) return true;
+  }
+  return false;
+}
+
+void Append(const string& flag, string* flags) {
+  if(flag.empty()) return;
+  flags->append(flags->empty() ? "" : " ").append(flag);
+}
+
+// MSVC accepts - in place of /
+string Normalize(const string& option) {
+  return option[0] == '-' ? "/" + option.substr(1) : option;
+}
+
+} // namespace
+
+void TokenizeOptions(const string& options, vector<string>* tokens) {
+  Split(options, false, tokens);
+}
+
+string TranslateCompilerOptions(const string& options, vector<string>* unknown) {
+  // switches taking an argument, either attached or as the next word
+  static const OptionFlags kArguments[] = {
+    {"/D", "-D"}, {"/U", "-U"}, {"/I", "-I"}, {"/FI", "-include "},
+  };
+
+  vector<string> tokens;
+  TokenizeOptions(options, &tokens);
+
+  string flags;
+  for(size_t i = 0; i < tokens.size(); ++i) {
+    // inherited options of property sheets
+    if(StartsWith(tokens[i], "%(") || StartsWith(tokens[i], "$(")) continue;
+    string option(Normalize(tokens[i]));
+
+    const char* translated = Find(kCompilerOptions, ARRAY_COUNT(kCompilerOptions), option);
+    if(translated) {
+      Append(translated, &flags);
+      continue;
+    }
+
+    bool argument = false;
+    for(size_t j = 0; j < ARRAY_COUNT(kArguments) && !argument; ++j) {
+      const OptionFlags& arg = kArguments[j];
+      if(!StartsWith(option, arg.option)) continue;
+
+      string value(option.substr(strlen(arg.option)));
+      if(value.empty() && i + 1 < tokens.size()) value = tokens[++i];
+      if(value.empty()) break;
+      if(strcmp(arg.option, "/I") == 0 || strcmp(arg.option, "/FI") == 0) {
+        value = ToUnixPaths(value);
+      }
+      Append(string(arg.flags) + Quote(value), &flags);
+      argument = true;
+    }
+    if(argument) continue;
+
+    if(!Ignored(kIgnoredCompilerPrefixes, ARRAY_COUNT(kIgnoredCompilerPrefixes), option)) {
+      unknown->push_back(tokens[i]);
+    }
+  }
+  return flags;
+}
+
+string TranslateLinkerOptions(const string& options, string* libraries,
+                              vector<string>* unknown) {
+  vector<string> tokens;
+  TokenizeOptions(options, &tokens);
+
+  string flags;
+  foreach(auto& token, tokens) {
+    if(StartsWith(token, "%(") || StartsWith(token, "$(")) continue;
+    string option(ToUpper(Normalize(token)));
+
+    const char* translated = Find(kLinkerOptions, ARRAY_COUNT(kLinkerOptions), option);
+    if(translated) {
+      Append(translated, &flags);
+    } else if(StartsWith(option, "/LIBPATH:")) {
+      Append("-L" + Quote(ToUnixPaths(token.substr(strlen("/LIBPATH:")))), &flags);
+    } else if(StartsWith(option, "/STACK:")) {
+      // reserve[,commit]
+      string reserve(token.substr(strlen("/STACK:")));
+      Append("-Wl,-z,stack-size=" + reserve.substr(0, reserve.find(',')), &flags);
+    } else if(option[0] != '/' && EndsWith(option, ".LIB")) {
+      string directory;
+      string library(LibraryFlag(token, &directory));
+      if(!directory.empty()) {
+        MergeFlags("-L" + Quote(directory), &flags);
+      }
+      if(!library.empty()) {
+        Append(Quote(library), libraries);
+      }
+    } else if(!Ignored(kIgnoredLinkerPrefixes, ARRAY_COUNT(kIgnoredLinkerPrefixes), option)) {
+      unknown->push_back(token);
+    }
+  }
+  return flags;
+}
+
+string LibraryFlag(const string& input, string* directory) {
+  directory->clear();
+  string library(ToUnixPaths(input));
+  size_t separator = library.rfind('/');
+  string name(separator == string::npos ? library : library.substr(separator + 1));
+  if(std::find(kWindowsLibraries, kWindowsLibraries + ARRAY_COUNT(kWindowsLibraries),
+               ToUpper(name)) != kWindowsLibraries + ARRAY_COUNT(kWindowsLibraries)) {
+    return "";
+  }
+
+  if(!EndsWith(ToUpper(name), ".LIB")) {
+    // other archives are named by their file, -l only searches -L directories
+    if(separator != string::npos) return library;
+    return name.find('.') == string::npos ? "-l" + name : "-l:" + name;
+  }
+
+  // dir\name.lib searches dir for libname
+  if(separator != string::npos) {
+    directory->assign(library.substr(0, separator));
+  }
+  return "-l" + name.substr(0, name.size() - strlen(".lib"));
+}
+
+void MergeFlags(const string& additional, string* flags) {
+  vector<string> existing;
+  vector<string> words;
+  SplitFlags(*flags, &existing);
+  SplitFlags(additional, &words);
+
+  foreach(auto& word, words) {
+    if(std::find(existing.begin(), existing.end(), word) == existing.end()) {
+      Append(word, flags);
+      existing.push_back(word);
+    }
+  }
+}
+
+bool RemoveFlag(const string& flag, string* flags) {
+  bool removed = false;
+  size_t pos = 0;
+  while((pos = flags->find(flag, pos)) != string::npos) {
+    size_t end = pos + flag.size();
+    bool word = (pos == 0 || isspace(static_cast<unsigned char>((*flags)[pos - 1]))) &&
+                (end == flags->size() || isspace(static_cast<unsigned char>((*flags)[end])));
+    if(!word) {
+      pos = end;
+      continue;
+    }
+
+    // take the separator after the flag, or before it at the end
+    if(end < flags->size()) {
+      end = flags->find_first_not_of(" \t", end);
+      if(end == string::npos) end = flags->size();
+    } else {
+      while(pos > 0 && isspace(static_cast<unsigned char>((*flags)[pos - 1]))) --pos;
+    }
+    flags->erase(pos, end - pos);
+    removed = true;
+  }
+  return removed;
+}
@@ -0,0 +1,91 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+#include <string>
+#include <vector>
+#include "libvs.h"
+
+// Returns the GCC and Clang code generation flags equivalent to a
+// configuration's optimization, floating point, instruction set,
+// OpenMP, buffer security check, RTTI and exception settings,
+// separated by spaces.
+//
+// Settings the project leaves unset add no flags. Inlining, frame
+// pointer and favor size settings only apply to optimized builds as
+// they do with MSVC.
+//
+// @cl  compiler settings of the configuration
+std::string CodeGenerationFlags(const vs::VCCLCompilerTool& cl);
+
+// Returns true if a configuration asks for link time code generation
+// through its WholeProgramOptimization, the compiler's
+// WholeProgramOptimization or the linker's LinkTimeCodeGeneration.
+// Profile guided optimizations count, they imply link time code
+// generation.
+//
+// @config  configuration to check
+bool LinkTimeOptimization(const vs::Configuration& config);
+
+// Splits an AdditionalOptions string into switches. Whitespace
+// separates switches except inside double quotes, which are removed.
+//
+// @options  AdditionalOptions of a tool
+// @tokens   switches in command line order
+void TokenizeOptions(const std::string& options, std::vector<std::string>* tokens);
+
+// Returns the GCC and Clang flags equivalent to the MSVC compiler
+// switches in a VCCLCompilerTool's AdditionalOptions, such as /GL,
+// /arch:AVX2, /fp:fast, /Oi, /Gy and /openmp. Switches accepted with
+// no equivalent, like /MP or /bigobj, add nothing.
+//
+// @options  AdditionalOptions of the compiler tool
+// @unknown  switches with no known translation are appended here
+std::string TranslateCompilerOptions(const std::string& options,
+                                     std::vector<std::string>* unknown);
+
+// Returns the GCC and Clang flags equivalent to the MSVC linker
+// switches in a VCLinkerTool's AdditionalOptions, such as /LTCG,
+// /OPT:REF and /LIBPATH:.
+//
+// @options    AdditionalOptions of the linker tool
+// @libraries  -l flags for the named .lib files, which belong after
+//             the objects on the link line
+// @unknown    switches with no known translation are appended here
+std::string TranslateLinkerOptions(const std::string& options, std::string* libraries,
+                                   std::vector<std::string>* unknown);
+
+// Returns the flag that links a linker input of AdditionalDependencies
+// or AdditionalOptions: -lname for name.lib, -l:file for other archive
+// names and the path itself for archives named with a directory.
+// Windows libraries of the default .lib list give an empty string.
+//
+// @input      linker input, with Windows or Unix separators
+// @directory  directory to search for the -l flag's library, or empty
+std::string LibraryFlag(const std::string& input, std::string* directory);
+
+// Appends each of additional's flags that flags doesn't already have.
+// Flags taking their argument as the next word, like -include x.h or
+// -Xlinker arg, compare together with the argument.
+//
+// @additional  flags separated by spaces
+// @flags       flags to append to
+void MergeFlags(const std::string& additional, std::string* flags);
+
+// Removes every occurrence of a flag.
+//
+// @flag   flag to remove
+// @flags  flags separated by spaces
+//
+// Returns true if flags had the flag
+bool RemoveFlag(const std::string& flag, std::string* flags);
@@ -0,0 +1,211 @@
+#ifdef VSTOMAKE_RUN_TESTS
+#include "compiler_flags.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include "libvs.h"
+#include "test_utility.h"
+
+namespace {
+using std::string;
+
+// Debug and Release configurations as Visual Studio writes them
+const char kCheckProject[] = "testing/vcclcompilertool_check/vcclcompilertool_check.vcproj";
+
+// CompilerFlagsTest Test fixture.
+class CompilerFlagsTest : public ::testing::Test {
+protected:
+
+  CompilerFlagsTest() : Projects(0) {}
+
+  // Parses a project with one configuration with the given attributes
+  // on it, its VCCLCompilerTool and its VCLinkerTool. Each project is
+  // written to a file of its own.
+  const vs::Configuration* Parse(const string& configuration, const string& compiler,
+                                 const string& linker) {
+    std::ostringstream name;
+    name << "flags" << ++Projects;
+    TestProject project(name.str());
+    project.Configuration("Release", configuration)
+           .Tool("VCCLCompilerTool", compiler)
+           .Tool("VCLinkerTool", linker)
+           .File("main.cc");
+
+    EXPECT_FALSE(Directory.path.empty());
+    EXPECT_EQ(ParseTestProject(Directory, project, &Project), "");
+    EXPECT_EQ(Project.Configurations.size(), 1);
+    return Project.Configurations.empty() ? 0 : &Project.Configurations[0];
+  }
+
+  // Parses the project at path into Project
+  void Load(const string& path) {
+    string status;
+    Project = vs::Project();
+    vs::Project::Parse(path, &Project, &status);
+    EXPECT_EQ(status, "");
+  }
+
+  // Returns the code generation flags of a VCCLCompilerTool with the
+  // given attributes.
+  string Flags(const string& attributes) {
+    const vs::Configuration* config = Parse("", attributes, "");
+    return config ? CodeGenerationFlags(config->CLCompilerTool) : "";
+  }
+
+  // Returns whether a configuration with the given attributes is
+  // built with link time optimization.
+  bool LinkTime(const string& configuration, const string& compiler, const string& linker) {
+    const vs::Configuration* config = Parse(configuration, compiler, linker);
+    return config && LinkTimeOptimization(*config);
+  }
+
+  TempDirectory Directory;
+  vs::Project Project;
+  int Projects;
+};
+
+TEST_F(CompilerFlagsTest, CheckProject) {
+  Load(kCheckProject);
+  ASSERT_EQ(Project.Configurations.size(), 2);
+  const vs::Configuration& debug = Project.Configurations[0];
+  const vs::Configuration& release = Project.Configurations[1];
+  ASSERT_EQ(debug.ConfigurationName, "Debug");
+  ASSERT_EQ(release.ConfigurationName, "Release");
+
+  // inlining and frame pointer settings of unoptimized builds add nothing
+  EXPECT_EQ(CodeGenerationFlags(debug.CLCompilerTool), "-O0 -ffast-math -fstack-protector-strong");
+  EXPECT_EQ(CodeGenerationFlags(release.CLCompilerTool),
+            "-O2 -fno-inline-functions -fbuiltin -fmerge-constants -ffast-math -msse2 "
+            "-fno-stack-protector -fno-rtti");
+  EXPECT_FALSE(LinkTimeOptimization(debug));
+  EXPECT_TRUE(LinkTimeOptimization(release));
+}
+
+TEST_F(CompilerFlagsTest, Unset) {
+  EXPECT_EQ(Flags(""), "");
+}
+
+TEST_F(CompilerFlagsTest, Optimization) {
+  EXPECT_EQ(Flags("Optimization=\"0\""), "-O0");
+  EXPECT_EQ(Flags("Optimization=\"1\""), "-Os");
+  EXPECT_EQ(Flags("Optimization=\"2\""), "-O2");
+  EXPECT_EQ(Flags("Optimization=\"3\""), "-O2");
+}
+
+TEST_F(CompilerFlagsTest, OptimizedOnly) {
+  EXPECT_EQ(Flags("Optimization=\"0\" FavorSizeOrSpeed=\"2\" OmitFramePointers=\"true\" "
+                  "InlineFunctionExpansion=\"0\""),
+            "-O0");
+  EXPECT_EQ(Flags("Optimization=\"2\" FavorSizeOrSpeed=\"2\" OmitFramePointers=\"true\" "
+                  "InlineFunctionExpansion=\"0\""),
+            "-O2 -Os -fno-inline -fomit-frame-pointer");
+  EXPECT_EQ(Flags("Optimization=\"2\" InlineFunctionExpansion=\"2\" OmitFramePointers=\"false\""),
+            "-O2 -finline-functions -fno-omit-frame-pointer");
+}
+
+TEST_F(CompilerFlagsTest, CodeGeneration) {
+  EXPECT_EQ(Flags("EnableIntrinsicFunctions=\"true\" StringPooling=\"true\""),
+            "-fbuiltin -fmerge-constants");
+  EXPECT_EQ(Flags("FloatingPointModel=\"2\""), "-ffast-math");
+  EXPECT_EQ(Flags("FloatingPointModel=\"0\""), "");
+  EXPECT_EQ(Flags("EnableEnhancedInstructionSet=\"2\" OpenMP=\"true\""), "-msse2 -fopenmp");
+  EXPECT_EQ(Flags("BufferSecurityCheck=\"false\" RuntimeTypeInfo=\"false\" ExceptionHandling=\"0\""),
+            "-fno-stack-protector -fno-rtti -fno-exceptions");
+  EXPECT_EQ(Flags("RuntimeTypeInfo=\"true\" ExceptionHandling=\"1\""), "");
+}
+
+TEST_F(CompilerFlagsTest, LinkTimeOptimization) {
+  EXPECT_FALSE(LinkTime("", "", ""));
+  EXPECT_FALSE(LinkTime("WholeProgramOptimization=\"0\"", "", "LinkTimeCodeGeneration=\"0\""));
+  EXPECT_TRUE(LinkTime("WholeProgramOptimization=\"1\"", "", ""));
+  EXPECT_TRUE(LinkTime("", "WholeProgramOptimization=\"true\"", ""));
+  EXPECT_TRUE(LinkTime("", "", "LinkTimeCodeGeneration=\"1\""));
+  EXPECT_TRUE(LinkTime("", "", "LinkTimeCodeGeneration=\"3\""));
+}
+
+TEST(AdditionalOptionsTest, Tokenize) {
+  std::vector<string> tokens;
+  TokenizeOptions(" /DNAME=\"a b\"\t/Oi  /I \"dir with spaces\" ", &tokens);
+  ASSERT_EQ(tokens.size(), 4);
+  EXPECT_EQ(tokens[0], "/DNAME=a b");
+  EXPECT_EQ(tokens[1], "/Oi");
+  EXPECT_EQ(tokens[2], "/I");
+  EXPECT_EQ(tokens[3], "dir with spaces");
+}
+
+TEST(AdditionalOptionsTest, Compiler) {
+  std::vector<string> unknown;
+  EXPECT_EQ(TranslateCompilerOptions("/GL /arch:AVX2 /fp:fast /Oi /Gy /openmp /MP4 -Gw", &unknown),
+            "-flto -mavx2 -mfma -ffast-math -fbuiltin -ffunction-sections -fopenmp -fdata-sections");
+  EXPECT_TRUE(unknown.empty());
+
+  EXPECT_EQ(TranslateCompilerOptions("/D X=1 /DY /I ..\\include /FIpre.h %(AdditionalOptions)", &unknown),
+            "-DX=1 -DY -I../include -include pre.h");
+  EXPECT_TRUE(unknown.empty());
+
+  EXPECT_EQ(TranslateCompilerOptions("/Qspectre /O2", &unknown), "-O2");
+  ASSERT_EQ(unknown.size(), 1);
+  EXPECT_EQ(unknown[0], "/Qspectre");
+}
+
+TEST(AdditionalOptionsTest, Linker) {
+  std::vector<string> unknown;
+  string libraries;
+  EXPECT_EQ(TranslateLinkerOptions("/LTCG /opt:ref /OPT:ICF /LIBPATH:..\\lib "
+                                   "kernel32.lib z.lib /STACK:1048576,4096", &libraries, &unknown),
+            "-flto -Wl,--gc-sections -L../lib -Wl,-z,stack-size=1048576");
+  EXPECT_EQ(libraries, "-lz");
+  EXPECT_TRUE(unknown.empty());
+
+  TranslateLinkerOptions("/WEIRD", &libraries, &unknown);
+  ASSERT_EQ(unknown.size(), 1);
+  EXPECT_EQ(unknown[0], "/WEIRD");
+}
+
+TEST(AdditionalOptionsTest, Library) {
+  string directory;
+  EXPECT_EQ(LibraryFlag("z.lib", &directory), "-lz");
+  EXPECT_EQ(directory, "");
+  EXPECT_EQ(LibraryFlag("..\\lib\\Foo.LIB", &directory), "-lFoo");
+  EXPECT_EQ(directory, "../lib");
+  EXPECT_EQ(LibraryFlag("libz.a", &directory), "-l:libz.a");
+  EXPECT_EQ(LibraryFlag("m", &directory), "-lm");
+  EXPECT_EQ(LibraryFlag("..\\lib\\libz.a", &directory), "../lib/libz.a");
+  EXPECT_EQ(directory, "");
+  EXPECT_EQ(LibraryFlag("C:\\SDK\\Kernel32.lib", &directory), "");
+
+  // the link line translates AdditionalOptions' inputs the same way
+  string libraries;
+  std::vector<string> unknown;
+  EXPECT_EQ(TranslateLinkerOptions("..\\lib\\Foo.LIB z.lib", &libraries, &unknown), "-L../lib");
+  EXPECT_EQ(libraries, "-lFoo -lz");
+}
+
+TEST(AdditionalOptionsTest, Merge) {
+  string flags("-O2 -fopenmp");
+  MergeFlags("-fopenmp -mavx2 -O2 -mavx2", &flags);
+  EXPECT_EQ(flags, "-O2 -fopenmp -mavx2");
+
+  // arguments of a repeated flag are kept
+  flags.assign("-include a.h -isystem /opt/a -x c++");
+  MergeFlags("-include b.h -include a.h -isystem /opt/b -x c++ -Xlinker -z -Xlinker defs", &flags);
+  EXPECT_EQ(flags, "-include a.h -isystem /opt/a -x c++ -include b.h -isystem /opt/b "
+                   "-Xlinker -z -Xlinker defs");
+}
+
+TEST(AdditionalOptionsTest, ForcedIncludes) {
+  std::vector<string> unknown;
+  string flags("-include pre.h");
+  MergeFlags(TranslateCompilerOptions("/FIfirst.h /FI second.h /FIpre.h", &unknown), &flags);
+  EXPECT_EQ(flags, "-include pre.h -include first.h -include second.h");
+  EXPECT_TRUE(unknown.empty());
+}
+
+TEST(AdditionalOptionsTest, Remove) {
+  string flags(" -flto -O2 -flto=jobserver -flto");
+  EXPECT_TRUE(RemoveFlag("-flto", &flags));
+  EXPECT_EQ(flags, " -O2 -flto=jobserver");
+  EXPECT_FALSE(RemoveFlag("-flto", &flags));
+}
+
+} //namespace
+#endif
@@ -0,0 +1,323 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "precompiled.h"
+#include "deplog.h"
+#include "utility.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char kDatabaseHeader[] = "# vstomake dependency database\n";
+const char kLogSuffix[] = ".log";
+const char kLockSuffix[] = ".lock";
+
+// object -> headers it includes, sorted and without duplicates
+typedef map<string, vector<string> > DependencyMap;
+
+// Joins lines continued with a trailing backslash
+string JoinContinuations(const string& text) {
+  string joined;
+  joined.reserve(text.size());
+  for(size_t i = 0, end = text.size(); i < end; ++i) {
+    if(text[i] == '\\' && i+1 < end && (text[i+1] == '\n' || text[i+1] == '\r')) {
+      i += text[i+1] == '\r' && i+2 < end && text[i+2] == '\n' ? 2 : 1;
+      joined.push_back(' ');
+    } else if(text[i] != '\r') {
+      joined.push_back(text[i]);
+    }
+  }
+  return joined;
+}
+
+// Splits make words on whitespace that isn't escaped with a
+// backslash. Escapes are kept so words can be written back as is.
+void SplitWords(const string& text, size_t begin, size_t end, vector<string>* words) {
+  string word;
+  for(size_t i = begin; i < end; ++i) {
+    if(text[i] == '\\' && i+1 < end) {
+      word.push_back(text[i]);
+      word.push_back(text[++i]);
+    } else if(text[i] == ' ' || text[i] == '\t') {
+      if(!word.empty()) words->push_back(word);
+      word.clear();
+    } else {
+      word.push_back(text[i]);
+    }
+  }
+  if(!word.empty()) words->push_back(word);
+}
+
+// Returns the position of the colon separating targets from
+// prerequisites, skipping drive letters such as C:/
+size_t FindRuleSeparator(const string& line) {
+  for(size_t i = 0, end = line.size(); i < end; ++i) {
+    if(line[i] == ':' && (i+1 == end || line[i+1] == ' ' || line[i+1] == '\t')) {
+      return i;
+    }
+  }
+  return string::npos;
+}
+
+void SortUnique(vector<string>* words) {
+  std::sort(words->begin(), words->end());
+  words->erase(std::unique(words->begin(), words->end()), words->end());
+}
+
+// Reads the first rule of a compiler dependency file. The first
+// prerequisite is the source itself which the pattern rules already
+// name, the empty rules added by -MP are ignored.
+bool ReadDependencyFile(const string& path, DependencyMap* dependencies) {
+  string text;
+  if(!FileToString(path, &text)) return false;
+
+  string joined(JoinContinuations(text));
+  size_t begin = 0;
+  while(begin < joined.size()) {
+    size_t end = joined.find('\n', begin);
+    if(end == string::npos) end = joined.size();
+
+    string line(joined.substr(begin, end - begin));
+    size_t separator = FindRuleSeparator(line);
+    if(separator != string::npos) {
+      vector<string> targets, headers;
+      SplitWords(line, 0, separator, &targets);
+      SplitWords(line, separator+1, line.size(), &headers);
+      if(!headers.empty()) headers.erase(headers.begin());
+      SortUnique(&headers);
+
+      foreach(auto& target, targets) {
+        (*dependencies)[target] = headers;
+      }
+      return true;
+    }
+    begin = end + 1;
+  }
+  return true;
+}
+
+// Reads every object rule of the database, an object may appear in
+// several rules. The rule naming every header has no prerequisites
+// and is rebuilt on write.
+void ReadDatabase(const string& text, DependencyMap* dependencies) {
+  size_t begin = 0;
+  while(begin < text.size()) {
+    size_t end = text.find('\n', begin);
+    if(end == string::npos) end = text.size();
+
+    if(text[begin] != '#') {
+      string line(text.substr(begin, end - begin));
+      size_t separator = FindRuleSeparator(line);
+      if(separator != string::npos) {
+        vector<string> targets, headers;
+        SplitWords(line, 0, separator, &targets);
+        SplitWords(line, separator+1, line.size(), &headers);
+        if(!headers.empty()) {
+          foreach(auto& target, targets) {
+            vector<string>& list = (*dependencies)[target];
+            list.insert(list.end(), headers.begin(), headers.end());
+          }
+        }
+      }
+    }
+    begin = end + 1;
+  }
+
+  foreach(auto& entry, *dependencies) {
+    SortUnique(&entry.second);
+  }
+}
+
+void WriteRule(const vector<string>& targets, const vector<string>& headers,
+               std::ostringstream& ss) {
+  for(size_t i = 0, end = targets.size(); i < end; ++i) {
+    ss << (i ? " " : "") << targets[i];
+  }
+  ss << ":";
+  foreach(auto& header, headers) {
+    ss << " " << header;
+  }
+  ss << "\n";
+}
+
+// Headers included by every object, typically those pulled in by a
+// precompiled or forced include header, are written once in a rule
+// naming every object. Objects with the same remaining headers share
+// a single rule. make merges the prerequisites of rules without
+// recipes so each object still depends on all of its headers.
+string WriteDatabase(const DependencyMap& dependencies) {
+  vector<string> objects, common;
+  set<string> headers;
+  foreach(auto& entry, dependencies) {
+    if(entry.second.empty()) continue;
+    if(objects.empty()) {
+      common = entry.second;
+    } else {
+      vector<string> shared;
+      std::set_intersection(common.begin(), common.end(),
+                            entry.second.begin(), entry.second.end(),
+                            std::back_inserter(shared));
+      common.swap(shared);
+    }
+    objects.push_back(entry.first);
+    headers.insert(entry.second.begin(), entry.second.end());
+  }
+  if(objects.size() < 2) common.clear();
+
+  map<vector<string>, vector<string> > groups;
+  foreach(auto& entry, dependencies) {
+    vector<string> remaining;
+    std::set_difference(entry.second.begin(), entry.second.end(),
+                        common.begin(), common.end(),
+                        std::back_inserter(remaining));
+    if(!remaining.empty()) groups[remaining].push_back(entry.first);
+  }
+
+  std::ostringstream ss;
+  ss << kDatabaseHeader;
+  if(!common.empty()) {
+    WriteRule(objects, common, ss);
+  }
+  foreach(auto& group, groups) {
+    WriteRule(group.second, group.first, ss);
+  }
+
+  if(!headers.empty()) {
+    ss << "# headers\n";
+    foreach(auto& header, headers) {
+      ss << header << " ";
+    }
+    ss << ":\n";
+  }
+  return ss.str();
+}
+
+// Returns the path a make word names, less its escapes
+string Unescape(const string& word) {
+  string path;
+  for(size_t i = 0, end = word.size(); i < end; ++i) {
+    if(i+1 < end && ((word[i] == '\\' && (word[i+1] == ' ' || word[i+1] == '#')) ||
+                     (word[i] == '$' && word[i+1] == '$'))) {
+      ++i;
+    }
+    path.push_back(word[i]);
+  }
+  return path;
+}
+
+// Reads the records of a log, one object rule per line. A record
+// replaces every earlier one of its objects, even when it names no
+// headers.
+void ReadLog(const string& text, DependencyMap* dependencies) {
+  size_t begin = 0;
+  while(begin < text.size()) {
+    size_t end = text.find('\n', begin);
+    if(end == string::npos) end = text.size();
+
+    string line(text.substr(begin, end - begin));
+    size_t separator = FindRuleSeparator(line);
+    if(separator != string::npos) {
+      vector<string> targets, headers;
+      SplitWords(line, 0, separator, &targets);
+      SplitWords(line, separator+1, line.size(), &headers);
+      SortUnique(&headers);
+      foreach(auto& target, targets) {
+        (*dependencies)[target] = headers;
+      }
+    }
+    begin = end + 1;
+  }
+}
+
+} // namespace
+
+bool AppendDependencyFile(const string& database, const string& depfile,
+                          string* error) {
+  DependencyMap update;
+  if(!ReadDependencyFile(depfile, &update)) {
+    error->assign("Unable to read " + depfile);
+    return false;
+  }
+
+  std::ostringstream record;
+  foreach(auto& entry, update) {
+    WriteRule(vector<string>(1, entry.first), entry.second, record);
+  }
+
+  // compaction removes the log, appending has to wait for it
+  FileLock lock(database + kLockSuffix);
+  if(!lock.locked()) {
+    error->assign("Unable to lock " + database + kLockSuffix);
+    return false;
+  }
+
+  string log(database + kLogSuffix);
+  std::ofstream fs(log.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+  fs << record.str();
+  fs.close();
+  if(!fs) {
+    error->assign("Unable to write " + log);
+    return false;
+  }
+
+  remove(depfile.c_str());
+  return true;
+}
+
+bool CompactDependencyDatabase(const string& database, string* error) {
+  FileLock lock(database + kLockSuffix);
+  if(!lock.locked()) {
+    error->assign("Unable to lock " + database + kLockSuffix);
+    return false;
+  }
+
+  string text;
+  DependencyMap dependencies;
+  if(FileToString(database, &text)) {
+    ReadDatabase(text, &dependencies);
+  }
+
+  string log(database + kLogSuffix);
+  string records;
+  if(FileToString(log, &records)) {
+    ReadLog(records, &dependencies);
+  }
+
+  for(auto entry = dependencies.begin(); entry != dependencies.end();) {
+    struct stat info;
+    if(stat(Unescape(entry->first).c_str(), &info) != 0) {
+      dependencies.erase(entry++);
+    } else {
+      ++entry;
+    }
+  }
+
+  if(!WriteFileIfChanged(database, WriteDatabase(dependencies))) {
+    error->assign("Unable to write " + database);
+    return false;
+  }
+
+  remove(log.c_str());
+  return true;
+}
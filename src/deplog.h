@@ -0,0 +1,51 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+#include <string>
+
+// A configuration's dependency database is a single Makefile included
+// by its fragment in place of one .d file per object. Objects that
+// include the same headers share one rule and every header is named
+// once in an empty rule so that deleting a header doesn't break the
+// build.
+//
+// Compiles don't rewrite the database, each appends its object's
+// record to <database>.log, which costs the same however many objects
+// the configuration has. The fragment compacts the log into the
+// database once per build, as make reads it. Both run under a lock
+// held on <database>.lock.
+
+// Appends the dependencies of a dependency file written by the
+// compiler (-MMD -MF) to the database's log and removes the dependency
+// file.
+//
+// @database  location of the configuration's dependency database
+// @depfile   dependency file emitted for a single object
+// @error     reason for failure
+//
+// Returns true on success
+bool AppendDependencyFile(const std::string& database, const std::string& depfile,
+                          std::string* error);
+
+// Merges the records of the database's log into the database, later
+// records replacing earlier ones of the same object, and removes the
+// log. Objects that no longer exist are dropped, they are rebuilt and
+// logged again. The database is only rewritten when its contents
+// change.
+//
+// @database  location of the configuration's dependency database
+// @error     reason for failure
+//
+// Returns true on success
+bool CompactDependencyDatabase(const std::string& database, std::string* error);
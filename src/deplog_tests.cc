@@ -0,0 +1,124 @@
+#ifdef VSTOMAKE_RUN_TESTS
+#include "deplog.h"
+#include <gtest/gtest.h>
+#include "test_utility.h"
+#include "utility.h"
+
+namespace {
+using std::string;
+
+// DependencyLogTest Test fixture.
+class DependencyLogTest : public ::testing::Test {
+protected:
+
+  // Called before each test(after the constructor).
+  virtual void SetUp() {
+    ASSERT_FALSE(Directory.path.empty());
+    Database = Directory.Path("deps.mk");
+  }
+
+  // Compiles an object, writing it and the dependency file the
+  // compiler would, then logs the dependency file.
+  //
+  // Returns the object's path
+  string Compile(const string& object, const string& headers) {
+    string path(Directory.Write(object, ""));
+    string depfile(Directory.Write(object + ".d",
+                                   path + ": src/" + object + ".cc \\\n " + headers + "\n"));
+    string error;
+    EXPECT_TRUE(AppendDependencyFile(Database, depfile, &error)) << error;
+    EXPECT_EQ(error, "");
+    return path;
+  }
+
+  // Returns the database after compacting it
+  string Compact() {
+    string error;
+    EXPECT_TRUE(CompactDependencyDatabase(Database, &error)) << error;
+    EXPECT_EQ(error, "");
+    string text;
+    FileToString(Database, &text);
+    return text;
+  }
+
+  bool Exists(const string& path) {
+    string text;
+    return FileToString(path, &text);
+  }
+
+  TempDirectory Directory;
+  string Database;
+};
+
+TEST_F(DependencyLogTest, Append) {
+  string a(Compile("a.o", "common.h a.h"));
+  string b(Compile("b.o", "common.h b.h"));
+
+  // compiles only append to the log
+  EXPECT_FALSE(Exists(Database));
+  EXPECT_FALSE(Exists(Directory.Path("a.o.d")));
+  string log;
+  ASSERT_TRUE(FileToString(Database + ".log", &log));
+  EXPECT_EQ(log, a + ": a.h common.h\n" + b + ": b.h common.h\n");
+
+  EXPECT_EQ(Compact(),
+            "# vstomake dependency database\n" +
+            a + " " + b + ": common.h\n" +
+            a + ": a.h\n" +
+            b + ": b.h\n"
+            "# headers\n"
+            "a.h b.h common.h :\n");
+  EXPECT_FALSE(Exists(Database + ".log"));
+}
+
+TEST_F(DependencyLogTest, Merge) {
+  string a(Compile("a.o", "common.h a.h"));
+  string b(Compile("b.o", "common.h b.h"));
+  Compact();
+
+  // later records replace the database's and earlier ones
+  Compile("a.o", "common.h old.h");
+  Compile("a.o", "common.h new.h");
+  Compile("c.o", "");
+  EXPECT_EQ(Compact(),
+            "# vstomake dependency database\n" +
+            a + " " + b + ": common.h\n" +
+            b + ": b.h\n" +
+            a + ": new.h\n"
+            "# headers\n"
+            "b.h common.h new.h :\n");
+
+  // nothing logged leaves the database as it is
+  string text(Compact());
+  EXPECT_EQ(Compact(), text);
+}
+
+TEST_F(DependencyLogTest, DeletedObjects) {
+  string a(Compile("a.o", "common.h a.h"));
+  string b(Compile("b.o", "common.h b.h"));
+  Compact();
+
+  remove(b.c_str());
+  Compile("c.o", "c.h");
+  string c(Directory.Path("c.o"));
+  EXPECT_EQ(Compact(),
+            "# vstomake dependency database\n" +
+            a + ": a.h common.h\n" +
+            c + ": c.h\n"
+            "# headers\n"
+            "a.h c.h common.h :\n");
+
+  remove(a.c_str());
+  remove(c.c_str());
+  EXPECT_EQ(Compact(), "# vstomake dependency database\n");
+}
+
+TEST_F(DependencyLogTest, MissingDependencyFile) {
+  string error;
+  EXPECT_FALSE(AppendDependencyFile(Database, Directory.Path("missing.d"), &error));
+  EXPECT_NE(error, "");
+  EXPECT_FALSE(Exists(Database + ".log"));
+}
+
+} //namespace
+#endif
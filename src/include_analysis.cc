@@ -0,0 +1,423 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "precompiled.h"
+#include "include_analysis.h"
+#include "internal.h"
+#include "string_tokenizer.h"
+#include "utility.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <map>
+#include <set>
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Number of headers listed by the report
+const size_t kReportedHeaders = 20;
+
+struct Include {
+  string name;
+  bool   angled;
+};
+
+// Collapses . and dir/.. components of a path using forward slashes
+string NormalizePath(const string& path) {
+  vector<string> parts;
+  StringTokenizer tok(path, "/");
+  while(tok.next()) {
+    string part(tok.token());
+    if(part == ".") continue;
+    if(part == ".." && !parts.empty() && parts.back() != "..") {
+      parts.pop_back();
+    } else {
+      parts.push_back(part);
+    }
+  }
+
+  string normalized(path.size() && path[0] == '/' ? "/" : "");
+  for(size_t i = 0, end = parts.size(); i < end; ++i) {
+    normalized.append(i ? "/" : "").append(parts[i]);
+  }
+  return normalized.empty() ? string(".") : normalized;
+}
+
+string JoinPath(const string& directory, const string& name) {
+  if(name.size() && (name[0] == '/' || (name.size() > 1 && name[1] == ':'))) return name;
+  if(directory.empty() || directory == ".") return NormalizePath(name);
+  return NormalizePath(directory + "/" + name);
+}
+
+string DirectoryOf(const string& path) {
+  size_t sep = path.find_last_of('/');
+  return sep == string::npos ? string(".") : path.substr(0, sep);
+}
+
+// Reads the header named by a line's #include directive, if any
+void ParseDirective(const string& line, vector<Include>* includes) {
+  size_t i = line.find_first_not_of(" \t");
+  if(i == string::npos || line[i] != '#') return;
+  i = line.find_first_not_of(" \t", i+1);
+  if(i == string::npos || line.compare(i, 7, "include") != 0) return;
+  i = line.find_first_not_of(" \t", i+7);
+  if(i == string::npos || (line[i] != '"' && line[i] != '<')) return;
+
+  size_t end = line.find(line[i] == '"' ? '"' : '>', i+1);
+  if(end == string::npos || end == i+1) return;
+
+  Include include = {line.substr(i+1, end-i-1), line[i] == '<'};
+  includes->push_back(include);
+}
+
+// Finds the #include directives of a file outside of comments.
+// Conditional compilation and macro expanded includes are ignored.
+void ScanIncludes(const string& text, vector<Include>* includes) {
+  bool in_comment = false;
+  size_t begin = 0;
+  while(begin < text.size()) {
+    size_t end = text.find('\n', begin);
+    if(end == string::npos) end = text.size();
+
+    string line;
+    char quote = 0;
+    for(size_t i = begin; i < end; ++i) {
+      char c = text[i];
+      if(in_comment) {
+        if(c == '*' && i+1 < end && text[i+1] == '/') {
+          in_comment = false;
+          line.push_back(' ');
+          ++i;
+        }
+      } else if(quote) {
+        line.push_back(c);
+        if(c == '\\' && i+1 < end) {
+          line.push_back(text[++i]);
+        } else if(c == quote) {
+          quote = 0;
+        }
+      } else if(c == '/' && i+1 < end && text[i+1] == '/') {
+        break;
+      } else if(c == '/' && i+1 < end && text[i+1] == '*') {
+        in_comment = true;
+        ++i;
+      } else {
+        if(c == '"' || c == '\'') quote = c;
+        line.push_back(c);
+      }
+    }
+
+    ParseDirective(line, includes);
+    begin = end + 1;
+  }
+}
+
+// Headers included by each file, resolved and scanned once
+struct IncludeGraph {
+  explicit IncludeGraph(const vector<string>& include_directories)
+    : include_directories(include_directories) {}
+
+  // Returns the location of an included header, empty if not found
+  //
+  // @name       header as spelled by the directive
+  // @angled     true for <name>, false for "name"
+  // @including  directory of the including file
+  string Resolve(const string& name, bool angled, const string& including) {
+    if(!angled) {
+      string path(JoinPath(including, name));
+      if(Exists(path)) return path;
+    }
+    foreach(auto& directory, include_directories) {
+      string path(JoinPath(directory, name));
+      if(Exists(path)) return path;
+    }
+    return string();
+  }
+
+  // Returns the headers a file includes directly
+  const vector<string>& Includes(const string& path) {
+    Node& node = Scan(path);
+    return node.includes;
+  }
+
+  uint64_t Size(const string& path) {
+    return Scan(path).size;
+  }
+
+  // Adds every header a file includes, directly or not, to headers
+  void Closure(const string& path, set<string>* headers) {
+    vector<string> pending(1, path);
+    while(!pending.empty()) {
+      string current(pending.back());
+      pending.pop_back();
+      foreach(auto& header, Includes(current)) {
+        if(headers->insert(header).second) {
+          pending.push_back(header);
+        }
+      }
+    }
+  }
+
+ private:
+  struct Node {
+    bool           scanned;
+    uint64_t       size;
+    vector<string> includes;
+  };
+
+  Node& Scan(const string& path) {
+    Node& node = nodes[path];
+    if(node.scanned) return node;
+    node.scanned = true;
+    node.size = 0;
+
+    string text;
+    if(!FileToString(path, &text)) return node;
+    node.size = text.size();
+
+    vector<Include> includes;
+    ScanIncludes(text, &includes);
+    string including(DirectoryOf(path));
+    foreach(auto& include, includes) {
+      string header(Resolve(ToUnixPaths(include.name), include.angled, including));
+      if(!header.empty()) node.includes.push_back(header);
+    }
+    return node;
+  }
+
+  bool Exists(const string& path) {
+    auto known = exists.find(path);
+    if(known != exists.end()) return known->second;
+
+    struct stat info;
+    bool found = stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFREG);
+    exists[path] = found;
+    return found;
+  }
+
+  vector<string>     include_directories;
+  map<string, Node>  nodes;
+  map<string, bool>  exists;
+};
+
+// Returns the shortest spelling of a header relative to
+// one of the include directories
+string Spelling(const string& path, const vector<string>& include_directories) {
+  string spelling;
+  foreach(auto& directory, include_directories) {
+    string relative;
+    if(directory == ".") {
+      if(path.compare(0, 3, "../") != 0 && path[0] != '/') relative = path;
+    } else if(path.compare(0, directory.size()+1, directory + "/") == 0) {
+      relative = path.substr(directory.size()+1);
+    }
+    if(!relative.empty() && (spelling.empty() || relative.size() < spelling.size())) {
+      spelling = relative;
+    }
+  }
+  return spelling;
+}
+
+bool MoreExpensive(const HeaderUsage& lhs, const HeaderUsage& rhs) {
+  uint64_t lhs_cost = lhs.fan_in * lhs.total_size;
+  uint64_t rhs_cost = rhs.fan_in * rhs.total_size;
+  if(lhs_cost != rhs_cost) return lhs_cost > rhs_cost;
+  return lhs.path < rhs.path;
+}
+
+bool Larger(const HeaderUsage& lhs, const HeaderUsage& rhs) {
+  if(lhs.total_size != rhs.total_size) return lhs.total_size > rhs.total_size;
+  return lhs.path < rhs.path;
+}
+
+string PrecompiledHeaderContents(const vs::Configuration& config,
+                                 const IncludeAnalysis& analysis) {
+  std::ostringstream ss;
+  ss << "// Precompiled header suggested by vstomake --analyze-includes for\n"
+     << "// " << config.Name << ": stable headers included by at least half of\n"
+     << "// the configuration's " << analysis.sources << " sources.\n"
+     << "#pragma once\n";
+  foreach(auto& header, analysis.precompiled) {
+    if(header.spelling.empty()) {
+      ss << "#include \"" << AbsoluteFilePath(header.path) << "\"\n";
+    } else {
+      ss << "#include <" << header.spelling << ">\n";
+    }
+  }
+  return ss.str();
+}
+
+void PrintAnalysis(const vs::Configuration& config, const IncludeAnalysis& analysis) {
+  printf("Configuration: %s\n", config.Name.c_str());
+  printf("  %u sources, %u headers, %llu bytes of headers parsed\n",
+         static_cast<unsigned>(analysis.sources), static_cast<unsigned>(analysis.headers.size()),
+         static_cast<unsigned long long>(analysis.parsed_bytes));
+
+  if(!analysis.headers.empty()) {
+    printf("\n  %8s %12s %12s  %s\n", "fan-in", "bytes", "total bytes", "header");
+  }
+  for(size_t i = 0, end = analysis.headers.size(); i < end && i < kReportedHeaders; ++i) {
+    const HeaderUsage& header = analysis.headers[i];
+    printf("  %8u %12llu %12llu  %s%s\n", static_cast<unsigned>(header.fan_in),
+           static_cast<unsigned long long>(header.size),
+           static_cast<unsigned long long>(header.total_size),
+           header.path.c_str(), header.stable ? "" : " (project)");
+  }
+
+  if(analysis.precompiled.empty()) {
+    printf("\n  No stable header is included by half of the sources,"
+           " a precompiled header isn't worthwhile.\n\n");
+    return;
+  }
+
+  printf("\n  Suggested precompiled header, covering %llu bytes (%u%%) of headers parsed:\n",
+         static_cast<unsigned long long>(analysis.covered_bytes),
+         static_cast<unsigned>(analysis.covered_bytes * 100 / analysis.parsed_bytes));
+  foreach(auto& header, analysis.precompiled) {
+    printf("    %s\n", header.path.c_str());
+  }
+  printf("\n");
+}
+
+} // namespace
+
+void AnalyzeIncludes(const vs::Project& project, const vs::Configuration& config,
+                     IncludeAnalysis* analysis) {
+  const vs::VCCLCompilerTool& cl = config.CLCompilerTool;
+  string project_dir(DirectoryOf(ToUnixPaths(project.Path)));
+
+  // the generated Makefile passes the project directory first
+  vector<string> include_directories(1, project_dir);
+  StringTokenizer directories(ToUnixPaths(cl.AdditionalIncludeDirectories()), ";");
+  while(directories.next()) {
+    string directory(Replace(directories.token(), "\"", ""));
+    if(!directory.empty()) include_directories.push_back(JoinPath(project_dir, directory));
+  }
+  IncludeGraph graph(include_directories);
+
+  set<string> project_files;
+  foreach(auto* file, config.Files) {
+    project_files.insert(JoinPath(project_dir, ToUnixPaths(file->RelativePath)));
+  }
+
+  vector<string> forced_includes;
+  StringTokenizer forced(ToUnixPaths(cl.ForcedIncludeFiles()), ";");
+  while(forced.next()) {
+    string header(graph.Resolve(Replace(forced.token(), "\"", ""), false, project_dir));
+    if(!header.empty()) forced_includes.push_back(header);
+  }
+
+  vector<vs::File*> sources;
+  vs::FilterCPPSources(config.Files, &sources);
+
+  // headers each source reads
+  vector<set<string> > closures(sources.size());
+  map<string, size_t> fan_in;
+  analysis->sources = sources.size();
+  analysis->parsed_bytes = 0;
+  analysis->covered_bytes = 0;
+  for(size_t i = 0, end = sources.size(); i < end; ++i) {
+    set<string>& closure = closures[i];
+    foreach(auto& header, forced_includes) {
+      closure.insert(header);
+      graph.Closure(header, &closure);
+    }
+    graph.Closure(JoinPath(project_dir, ToUnixPaths(sources[i]->RelativePath)), &closure);
+
+    foreach(auto& header, closure) {
+      ++fan_in[header];
+      analysis->parsed_bytes += graph.Size(header);
+    }
+  }
+
+  map<string, set<string> > header_closures;
+  analysis->headers.clear();
+  foreach(auto& entry, fan_in) {
+    set<string>& closure = header_closures[entry.first];
+    graph.Closure(entry.first, &closure);
+
+    HeaderUsage usage;
+    usage.path = entry.first;
+    usage.spelling = Spelling(entry.first, include_directories);
+    usage.fan_in = entry.second;
+    usage.size = graph.Size(entry.first);
+    usage.total_size = usage.size;
+    foreach(auto& header, closure) {
+      if(header != entry.first) usage.total_size += graph.Size(header);
+    }
+    usage.stable = project_files.find(entry.first) == project_files.end();
+    analysis->headers.push_back(usage);
+  }
+  std::sort(analysis->headers.begin(), analysis->headers.end(), MoreExpensive);
+
+  // The largest candidates go first so a header that includes another
+  // candidate is chosen in its place.
+  vector<HeaderUsage> candidates;
+  foreach(auto& header, analysis->headers) {
+    if(header.stable && sources.size() > 1 && header.fan_in * 2 >= sources.size()) {
+      candidates.push_back(header);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), Larger);
+
+  set<string> covered;
+  analysis->precompiled.clear();
+  foreach(auto& header, candidates) {
+    if(covered.find(header.path) != covered.end()) continue;
+    covered.insert(header.path);
+    covered.insert(header_closures[header.path].begin(), header_closures[header.path].end());
+    analysis->precompiled.push_back(header);
+  }
+
+  foreach(auto& closure, closures) {
+    foreach(auto& header, closure) {
+      if(covered.find(header) != covered.end()) {
+        analysis->covered_bytes += graph.Size(header);
+      }
+    }
+  }
+}
+
+int DoAnalyzeIncludes(const vs::Project& project, const string& config_name,
+                      const string& directory) {
+  bool found = false;
+  foreach(auto& config, project.Configurations) {
+    if(config_name != "-a" && config.Name != config_name) continue;
+    found = true;
+
+    IncludeAnalysis analysis;
+    AnalyzeIncludes(project, config, &analysis);
+    PrintAnalysis(config, analysis);
+
+    if(!directory.empty() && !analysis.precompiled.empty()) {
+      string path(directory + "/" + config.ConfigurationName + config.Platform + "_pch.h");
+      if(!WriteFileIfChanged(path, PrecompiledHeaderContents(config, analysis))) {
+        fprintf(stderr, "vstomake: Unable to write %s\n", path.c_str());
+        return 1;
+      }
+      printf("Output: %s\n", path.c_str());
+    }
+  }
+  fflush(stdout);
+
+  if(!found) {
+    fprintf(stderr, "vstomake: No configuration named %s\n", config_name.c_str());
+    return 1;
+  }
+  return 0;
+}
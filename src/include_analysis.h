@@ -0,0 +1,84 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "libvs.h"
+
+// A header reached from a configuration's sources
+struct HeaderUsage {
+  // location of the header, relative to the working directory
+  std::string path;
+
+  // spelling that finds the header through the include directories
+  std::string spelling;
+
+  // number of sources that include the header directly or not
+  size_t fan_in;
+
+  // bytes of the header and of every header it includes
+  uint64_t size;
+  uint64_t total_size;
+
+  // not one of the project's own files, so unlikely to change
+  bool stable;
+};
+
+struct IncludeAnalysis {
+  size_t sources;
+
+  // bytes of headers read compiling every source, and the part of
+  // them the suggested precompiled header would cover
+  uint64_t parsed_bytes;
+  uint64_t covered_bytes;
+
+  // every header reached, the most expensive first
+  std::vector<HeaderUsage> headers;
+
+  // headers the suggested precompiled header should include
+  std::vector<HeaderUsage> precompiled;
+};
+
+// Scans every source of a configuration for the headers it includes
+// and suggests the contents of a precompiled header.
+//
+// The scanner reads #include directives outside comments and ignores
+// conditional compilation, so it may see more headers than the
+// compiler does. Quoted includes are searched beside the including
+// file first, then like angled includes in the project directory
+// and AdditionalIncludeDirectories. Headers found in neither, such as
+// the system's, are not followed. ForcedIncludeFiles count as
+// included by every source.
+//
+// The suggestion holds the stable headers included by at least half
+// of the sources, less those already included by another of them.
+//
+// @project   project the configuration belongs to
+// @config    configuration to analyze
+// @analysis  results
+void AnalyzeIncludes(const vs::Project& project, const vs::Configuration& config,
+                     IncludeAnalysis* analysis);
+
+// Prints the include analysis of each matching configuration and
+// optionally writes the suggested precompiled headers.
+//
+// @project      project to analyze
+// @config_name  configuration name or -a for every configuration
+// @directory    where [configuration][platform]_pch.h is written for
+//               each configuration, nothing is written if empty
+//
+// Returns the process exit code
+int DoAnalyzeIncludes(const vs::Project& project, const std::string& config_name,
+                      const std::string& directory);
@@ -40,10 +40,6 @@ using std::exception;
 using std::copy;
 using std::copy_if;
 
-// error handler for rapidxml (when exceptions are disabled)
-void rapidxml::parse_error_handler(const char*, void*) {
-  exit(1);
-}
 
 
 void ParseVCXPROJ();
@@ -58,10 +54,16 @@ namespace vs {
 
 
 bool Project::Parse(const std::string& filepath, Project* ptr, std::string* errors /*= 0*/) {
-  using namespace Enum;
-  std::string dummy("");
-  if(!errors) errors = &dummy;
+  string buffer("");
+  FileToString(filepath, &buffer);
+  return Parse(filepath, buffer.data(), buffer.length(), ptr, errors);
+}
 
+// Parses the project in buffer, rapidxml::parse_error is thrown
+// for malformed XML in the project or its property sheets
+static bool ParseProject(const std::string& filepath, const char* buffer, size_t len,
+                         Project* ptr, std::string* errors) {
+  using namespace Enum;
   Enum::Format format = GetFormat(filepath);
   if(format == Enum::Format_unknown) {
     errors->append("Unknown file format: ");
@@ -82,7 +84,7 @@ bool Project::Parse(const std::string& filepath, Project* ptr, std::string* erro
   switch(format) {
     case Format_sln:
       errors->append("Solution files aren't supported yet.");
-      break;
+      return false;
 
     case Format_vcproj:
       parser = &vcproj;
@@ -103,12 +105,7 @@ bool Project::Parse(const std::string& filepath, Project* ptr, std::string* erro
   }
 
 
-  string buffer("");
-  FileToString(filepath, &buffer);
-  buffer.push_back('\0');
-   
-   
-  if(parser->Parse(filepath)) {
+  if(parser->Parse(filepath, buffer, len)) {
     unordered_map<string, string> props;
 
     if(!parser->ProjectProperties(&props)) {
@@ -139,32 +136,55 @@ bool Project::Parse(const std::string& filepath, Project* ptr, std::string* erro
     }
 
 
-    foreach(auto& c, ptr->Configurations) {
+    Project::Resolve(ptr);
+  }
+
+  return false;
+}
+
+bool Project::Parse(const std::string& filepath, const char* buffer, size_t len,
+                    Project* ptr, std::string* errors /*= 0*/) {
+  std::string dummy("");
+  if(!errors) errors = &dummy;
+
+  // malformed XML is reported like any other error, library code
+  // never terminates the process on behalf of its caller
+  try {
+    return ParseProject(filepath, buffer, len, ptr, errors);
+  } catch(const rapidxml::parse_error& e) {
+    errors->append(filepath);
+    errors->append(": malformed XML, ");
+    errors->append(e.what());
+    return false;
+  }
+}
+
+void Project::Resolve(Project* ptr) {
+  foreach(auto& c, ptr->Configurations) {
+    c.Files.clear();
 
-      // assign tool pointers
-      auto& cltool = c.ToolProperties["VCCLCompilerTool"];
-      c.CLCompilerTool.properties = &cltool;
+    // assign tool pointers
+    auto& cltool = c.ToolProperties["VCCLCompilerTool"];
+    c.CLCompilerTool.properties = &cltool;
+    c.LinkerTool.properties     = &c.ToolProperties["VCLinkerTool"];
 
-      string forced_includes(cltool["ForcedIncludeFiles"]);
+    string forced_includes(cltool["ForcedIncludeFiles"]);
 
-      foreach(auto& file, ptr->Files) {
-        auto iter = std::find(file.Excluded.begin(), file.Excluded.end(), c.Name);
+    foreach(auto& file, ptr->Files) {
+      auto iter = std::find(file.Excluded.begin(), file.Excluded.end(), c.Name);
 
-        if(iter == file.Excluded.end()) {
-          c.Files.push_back(&file);
-        }
+      if(iter == file.Excluded.end()) {
+        c.Files.push_back(&file);
+      }
 
-        if(forced_includes.empty())
-          continue;
+      if(forced_includes.empty())
+        continue;
 
-        StringTokenizer tok(forced_includes, ";");
-        while(tok.next()) {
-          file.ForcedInclude = file.RelativePath.find(tok.token()) != string::npos;
-        }
+      StringTokenizer tok(forced_includes, ";");
+      while(tok.next()) {
+        file.ForcedInclude = file.RelativePath.find(tok.token()) != string::npos;
       }
     }
   }
-
-  return false;
 }
 }
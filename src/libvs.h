@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "vcclcompilertool.h"
+#include "vclinkertool.h"
 namespace vs {
 
 namespace Enum {
@@ -225,6 +226,9 @@ struct File {
   bool        ForcedInclude;
   bool        Precompiled;
   bool        CompileAsC;
+
+  // a FileConfiguration sets tool properties of its own for the file
+  bool        ToolOverrides;
 };
 
 
@@ -260,6 +264,7 @@ struct Configuration {
   Enum::UseMfc           UseOfMfc;
   Enum::Optimization     WholeProgramOptimization;
   VCCLCompilerTool CLCompilerTool;
+  VCLinkerTool     LinkerTool;
 };
 
 
@@ -277,6 +282,26 @@ struct Project{
   // If parsing succeeds this function returns true with status as an empty string else
   // status will contain a relevent error message
   static bool Parse(const std::string& filepath, Project* ptr, std::string* status = 0);
+
+  // Parse the given in memory contents of the project file located
+  // at filepath into ptr. filepath is still used to determine the
+  // format and to resolve relative paths and property sheets.
+  //
+  // @filepath  location of the project file
+  // @buffer    contents of the project file
+  // @len       byte length of buffer
+  // @ptr       pointer to user allocated Project structure
+  // @status    pointer to user allocated string to hold error messages(optional)
+  static bool Parse(const std::string& filepath, const char* buffer, size_t len,
+                    Project* ptr, std::string* status = 0);
+
+  // Rebuilds each configuration's file list and tool accessors
+  // from Files and ToolProperties. Parse calls this itself; it is
+  // only needed when a Project is populated by other means
+  // (see project_cache.h).
+  //
+  // @ptr       pointer to a populated Project structure
+  static void Resolve(Project* ptr);
   
   
   // All files referenced by the project
@@ -0,0 +1,286 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "precompiled.h"
+#include "libvs_c.h"
+#include "libvs.h"
+#include "make_file.h"
+#include "output_option.h"
+
+#include <deque>
+#include <memory>
+
+using std::string;
+
+struct vs_project {
+  vs::Project project;
+  string      errors;
+
+  // values computed on request, kept for the lifetime of the handle
+  // so views into them stay valid
+  std::deque<string> strings;
+};
+
+struct vs_makefile {
+  vs_makefile(const vs::Project& project, const string& path)
+    : makefile(project, path, MakefileOptions()) {}
+  Makefile makefile;
+
+  // contiguous copies made by vs_makefile_contents and
+  // vs_makefile_fragment_contents
+  std::deque<string> strings;
+};
+
+namespace {
+
+const vs_string_view kEmptyView = {"", 0};
+
+vs_string_view View(const string& str) {
+  vs_string_view view = {str.c_str(), str.size()};
+  return view;
+}
+
+vs_string_view ChunkView(const OutputBuffer& buffer, size_t chunk) {
+  if(chunk >= buffer.chunk_count()) return kEmptyView;
+  vs_string_view view = {0, 0};
+  view.data = buffer.chunk(chunk, &view.size);
+  return view;
+}
+
+const OutputBuffer* GetFragment(const vs_makefile* makefile, size_t fragment) {
+  if(!makefile || fragment >= makefile->makefile.fragments.size()) return 0;
+  return &makefile->makefile.fragments[fragment].contents;
+}
+
+const vs::Configuration* GetConfiguration(const vs_project* project, size_t config) {
+  if(!project || config >= project->project.Configurations.size()) return 0;
+  return &project->project.Configurations[config];
+}
+
+const string* GetProperty(const vs_project* project, size_t config,
+                          const char* tool, const char* property) {
+  const vs::Configuration* c = GetConfiguration(project, config);
+  if(!c || !tool || !property) return 0;
+
+  auto props = c->ToolProperties.find(tool);
+  if(props == c->ToolProperties.end()) return 0;
+
+  auto value = props->second.find(property);
+  return value == props->second.end() ? 0 : &value->second;
+}
+
+// Calls function, returning failure in its place if it throws. No
+// exception may cross into the C caller.
+template<typename Result, typename Function>
+Result Guard(Result failure, Function function) {
+  try {
+    return function();
+  } catch(...) {
+    return failure;
+  }
+}
+
+} // namespace
+
+extern "C" {
+
+int vs_api_version(void) {
+  return VS_API_VERSION;
+}
+
+vs_project* vs_project_parse(const char* path, const char* buffer, size_t len) {
+  return Guard(static_cast<vs_project*>(0), [&]() -> vs_project* {
+    std::unique_ptr<vs_project> project(new vs_project);
+    if(buffer) {
+      vs::Project::Parse(path, buffer, len, &project->project, &project->errors);
+    } else {
+      vs::Project::Parse(path, &project->project, &project->errors);
+    }
+    return project.release();
+  });
+}
+
+void vs_project_free(vs_project* project) {
+  delete project;
+}
+
+vs_string_view vs_project_errors(const vs_project* project) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    return project ? View(project->errors) : kEmptyView;
+  });
+}
+
+vs_string_view vs_project_name(const vs_project* project) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    return project ? View(project->project.Name) : kEmptyView;
+  });
+}
+
+size_t vs_configuration_count(const vs_project* project) {
+  return Guard(size_t(0), [&]() -> size_t {
+    return project ? project->project.Configurations.size() : 0;
+  });
+}
+
+vs_string_view vs_configuration_name(const vs_project* project, size_t config) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    const vs::Configuration* c = GetConfiguration(project, config);
+    return c ? View(c->Name) : kEmptyView;
+  });
+}
+
+vs_string_view vs_configuration_intermediate_directory(const vs_project* project, size_t config) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    const vs::Configuration* c = GetConfiguration(project, config);
+    return c ? View(c->IntermediateDirectory) : kEmptyView;
+  });
+}
+
+vs_string_view vs_configuration_output_directory(const vs_project* project, size_t config) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    const vs::Configuration* c = GetConfiguration(project, config);
+    return c ? View(c->OutputDirectory) : kEmptyView;
+  });
+}
+
+size_t vs_configuration_file_count(const vs_project* project, size_t config) {
+  return Guard(size_t(0), [&]() -> size_t {
+    const vs::Configuration* c = GetConfiguration(project, config);
+    return c ? c->Files.size() : 0;
+  });
+}
+
+vs_string_view vs_configuration_file(const vs_project* project, size_t config, size_t file) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    const vs::Configuration* c = GetConfiguration(project, config);
+    if(!c || file >= c->Files.size()) return kEmptyView;
+    return View(c->Files[file]->RelativePath);
+  });
+}
+
+vs_string_view vs_configuration_option(vs_project* project, size_t config, const char* option) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    const vs::Configuration* c = GetConfiguration(project, config);
+    string values;
+    if(!c || !option || !OutputOptionValues(*c, option, &values) || values.empty()) {
+      return kEmptyView;
+    }
+    project->strings.push_back(values);
+    return View(project->strings.back());
+  });
+}
+
+vs_string_view vs_tool_property(const vs_project* project, size_t config,
+                                const char* tool, const char* property) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    const string* value = GetProperty(project, config, tool, property);
+    return value ? View(*value) : kEmptyView;
+  });
+}
+
+int vs_tool_property_bool(const vs_project* project, size_t config,
+                          const char* tool, const char* property) {
+  return Guard(0, [&]() -> int {
+    const string* value = GetProperty(project, config, tool, property);
+    if(!value) return 0;
+
+    string lower(*value);
+    std::transform(lower.begin(), lower.end(), lower.begin(), tolower);
+    return lower == "true";
+  });
+}
+
+long vs_tool_property_int(const vs_project* project, size_t config,
+                          const char* tool, const char* property) {
+  return Guard(0L, [&]() -> long {
+    const string* value = GetProperty(project, config, tool, property);
+    return value ? strtol(value->c_str(), 0, 10) : 0;
+  });
+}
+
+vs_makefile* vs_makefile_generate(const vs_project* project, const char* path) {
+  return Guard(static_cast<vs_makefile*>(0), [&]() -> vs_makefile* {
+    if(!project) return 0;
+    return new vs_makefile(project->project, path ? path : "");
+  });
+}
+
+void vs_makefile_free(vs_makefile* makefile) {
+  delete makefile;
+}
+
+vs_string_view vs_makefile_contents(vs_makefile* makefile) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    if(!makefile || makefile->makefile.contents.empty()) return kEmptyView;
+    makefile->strings.push_back(makefile->makefile.contents.str());
+    return View(makefile->strings.back());
+  });
+}
+
+size_t vs_makefile_chunk_count(const vs_makefile* makefile) {
+  return Guard(size_t(0), [&]() -> size_t {
+    return makefile ? makefile->makefile.contents.chunk_count() : 0;
+  });
+}
+
+vs_string_view vs_makefile_chunk(const vs_makefile* makefile, size_t chunk) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    return makefile ? ChunkView(makefile->makefile.contents, chunk) : kEmptyView;
+  });
+}
+
+size_t vs_makefile_fragment_count(const vs_makefile* makefile) {
+  return Guard(size_t(0), [&]() -> size_t {
+    return makefile ? makefile->makefile.fragments.size() : 0;
+  });
+}
+
+vs_string_view vs_makefile_fragment_name(const vs_makefile* makefile, size_t fragment) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    if(!makefile || fragment >= makefile->makefile.fragments.size()) return kEmptyView;
+    return View(makefile->makefile.fragments[fragment].name);
+  });
+}
+
+vs_string_view vs_makefile_fragment_contents(vs_makefile* makefile, size_t fragment) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    const OutputBuffer* contents = GetFragment(makefile, fragment);
+    if(!contents || contents->empty()) return kEmptyView;
+    makefile->strings.push_back(contents->str());
+    return View(makefile->strings.back());
+  });
+}
+
+size_t vs_makefile_fragment_chunk_count(const vs_makefile* makefile, size_t fragment) {
+  return Guard(size_t(0), [&]() -> size_t {
+    const OutputBuffer* contents = GetFragment(makefile, fragment);
+    return contents ? contents->chunk_count() : 0;
+  });
+}
+
+vs_string_view vs_makefile_fragment_chunk(const vs_makefile* makefile, size_t fragment,
+                                          size_t chunk) {
+  return Guard(kEmptyView, [&]() -> vs_string_view {
+    const OutputBuffer* contents = GetFragment(makefile, fragment);
+    return contents ? ChunkView(*contents, chunk) : kEmptyView;
+  });
+}
+
+int vs_makefile_write(const vs_makefile* makefile, const char* path) {
+  return Guard(0, [&]() -> int {
+    if(!makefile || !path) return 0;
+    return makefile->makefile.Write(path);
+  });
+}
+
+} // extern "C"
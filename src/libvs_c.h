@@ -0,0 +1,142 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+// C interface to libvs for in-process use of the project parser and
+// Makefile generator (see libvs.vcproj for the static and shared
+// library builds).
+//
+// Strings are returned as views into memory owned by the project or
+// Makefile handle they came from. A view stays valid until its handle
+// is freed, has a size of 0 when the value is empty or unset and,
+// except for Makefile chunks, is NUL terminated. Configurations and files are addressed by
+// index; an index that is out of range yields an empty view or 0.
+//
+// No C++ exception leaves the library. A function that fails, out of
+// memory for instance, returns NULL, an empty view or 0 instead.
+
+#include <stddef.h>
+
+#if defined(_WIN32) && defined(LIBVS_SHARED)
+#  ifdef LIBVS_EXPORTS
+#    define VS_API __declspec(dllexport)
+#  else
+#    define VS_API __declspec(dllimport)
+#  endif
+#else
+// other shared builds export every symbol by default
+#  define VS_API
+#endif
+
+// Incremented whenever a function's behavior changes incompatibly
+#define VS_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct vs_string_view {
+  const char* data;
+  size_t      size;
+} vs_string_view;
+
+typedef struct vs_project  vs_project;
+typedef struct vs_makefile vs_makefile;
+
+// Returns VS_API_VERSION of the library in use
+VS_API int vs_api_version(void);
+
+// Parse a project.
+//
+// @path    location of the project file, used to determine its format
+//          and to resolve relative paths and property sheets
+// @buffer  contents of the project file, or NULL to read it from path
+// @len     byte length of buffer
+//
+// Returns a handle to free with vs_project_free, or NULL if out of
+// memory. Check vs_project_errors for parse errors, including
+// malformed XML.
+VS_API vs_project* vs_project_parse(const char* path, const char* buffer, size_t len);
+VS_API void vs_project_free(vs_project* project);
+
+// Returns an empty view if the project was parsed successfully
+VS_API vs_string_view vs_project_errors(const vs_project* project);
+VS_API vs_string_view vs_project_name(const vs_project* project);
+
+VS_API size_t         vs_configuration_count(const vs_project* project);
+
+// "Debug|Win32", "Release|Win32" etc.
+VS_API vs_string_view vs_configuration_name(const vs_project* project, size_t config);
+VS_API vs_string_view vs_configuration_intermediate_directory(const vs_project* project, size_t config);
+VS_API vs_string_view vs_configuration_output_directory(const vs_project* project, size_t config);
+
+// Files that are not excluded from the configuration, as
+// paths relative to the project file
+VS_API size_t         vs_configuration_file_count(const vs_project* project, size_t config);
+VS_API vs_string_view vs_configuration_file(const vs_project* project, size_t config, size_t file);
+
+// Values of an output option (-i -I -l -L -D -s) separated by spaces,
+// as printed by vstomake [input] [option] [configuration name]
+VS_API vs_string_view vs_configuration_option(vs_project* project, size_t config,
+                                              const char* option);
+
+// Tool property accessors.
+//
+// @tool      "VCCLCompilerTool", "VCLinkerTool" etc.
+// @property  attribute name, e.g. "PreprocessorDefinitions"
+//
+// vs_tool_property returns the value as written in the project,
+// vs_tool_property_bool returns non-zero if it is "true" in any case and
+// vs_tool_property_int returns its integer value or 0 if unset.
+VS_API vs_string_view vs_tool_property(const vs_project* project, size_t config,
+                                       const char* tool, const char* property);
+VS_API int            vs_tool_property_bool(const vs_project* project, size_t config,
+                                            const char* tool, const char* property);
+VS_API long           vs_tool_property_int(const vs_project* project, size_t config,
+                                           const char* tool, const char* property);
+
+// Generate a Makefile for the project.
+//
+// @path  location the Makefile will be written to, or NULL. Fragments
+//        already up to date at that location are left empty.
+//
+// Returns a handle to free with vs_makefile_free, or NULL if out of memory
+VS_API vs_makefile* vs_makefile_generate(const vs_project* project, const char* path);
+VS_API void vs_makefile_free(vs_makefile* makefile);
+
+// The generated text is held in fixed size chunks. The chunk
+// accessors return views of them in order without copying; the
+// contents accessors return a contiguous copy owned by the handle.
+VS_API vs_string_view vs_makefile_contents(vs_makefile* makefile);
+VS_API size_t         vs_makefile_chunk_count(const vs_makefile* makefile);
+VS_API vs_string_view vs_makefile_chunk(const vs_makefile* makefile, size_t chunk);
+
+// Per configuration fragments included by the Makefile
+VS_API size_t         vs_makefile_fragment_count(const vs_makefile* makefile);
+VS_API vs_string_view vs_makefile_fragment_name(const vs_makefile* makefile, size_t fragment);
+
+// Fragments that are up to date have no contents and no chunks
+VS_API vs_string_view vs_makefile_fragment_contents(vs_makefile* makefile, size_t fragment);
+VS_API size_t         vs_makefile_fragment_chunk_count(const vs_makefile* makefile, size_t fragment);
+VS_API vs_string_view vs_makefile_fragment_chunk(const vs_makefile* makefile, size_t fragment,
+                                                 size_t chunk);
+
+// Write the Makefile and any fragments that changed.
+//
+// Returns non-zero on success
+VS_API int vs_makefile_write(const vs_makefile* makefile, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,79 @@
+#ifdef VSTOMAKE_RUN_TESTS
+#include "libvs_c.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include "test_utility.h"
+
+namespace {
+using std::string;
+
+// The project queried through the C interface
+TestProject CapiProject() {
+  TestProject project("capi");
+  project.Configuration("Release")
+         .Tool("VCCLCompilerTool",
+               "Optimization=\"2\" StringPooling=\"TRUE\" OpenMP=\"false\" "
+               "WarnAsError=\"untrue\" RuntimeTypeInfo=\"true \"")
+         .File("main.cc");
+  return project;
+}
+
+string Str(vs_string_view view) {
+  return string(view.data, view.size);
+}
+
+TEST(LibvsCTest, ToolProperties) {
+  TempDirectory directory;
+  ASSERT_FALSE(directory.path.empty());
+  vs_project* project = vs_project_parse(CapiProject().Write(directory).c_str(), 0, 0);
+  ASSERT_TRUE(project != 0);
+  EXPECT_EQ(Str(vs_project_errors(project)), "");
+  ASSERT_EQ(vs_configuration_count(project), 1);
+
+  const char* cl = "VCCLCompilerTool";
+  EXPECT_EQ(Str(vs_tool_property(project, 0, cl, "Optimization")), "2");
+  EXPECT_EQ(vs_tool_property_int(project, 0, cl, "Optimization"), 2);
+  EXPECT_EQ(vs_tool_property_bool(project, 0, cl, "StringPooling"), 1);
+  EXPECT_EQ(vs_tool_property_bool(project, 0, cl, "OpenMP"), 0);
+  EXPECT_EQ(vs_tool_property_bool(project, 0, cl, "WarnAsError"), 0);
+  EXPECT_EQ(vs_tool_property_bool(project, 0, cl, "RuntimeTypeInfo"), 0);
+  EXPECT_EQ(vs_tool_property_bool(project, 0, cl, "Unset"), 0);
+  EXPECT_EQ(vs_tool_property_bool(project, 1, cl, "StringPooling"), 0);
+  vs_project_free(project);
+}
+
+TEST(LibvsCTest, Invalid) {
+  EXPECT_EQ(vs_configuration_count(0), 0);
+  EXPECT_EQ(vs_project_errors(0).size, 0);
+  EXPECT_TRUE(vs_makefile_generate(0, 0) == 0);
+  EXPECT_EQ(vs_makefile_write(0, "Makefile"), 0);
+
+  vs_project* project = vs_project_parse("missing.vcproj", 0, 0);
+  ASSERT_TRUE(project != 0);
+  EXPECT_NE(vs_project_errors(project).size, 0);
+  EXPECT_EQ(vs_configuration_count(project), 0);
+  EXPECT_EQ(vs_configuration_option(project, 0, "-D").size, 0);
+  vs_project_free(project);
+}
+
+TEST(LibvsCTest, Malformed) {
+  TempDirectory directory;
+  ASSERT_FALSE(directory.path.empty());
+  string path(CapiProject().Write(directory));
+
+  // malformed contents are an error, not the end of the process
+  const char truncated[] = "<VisualStudioProject Name=\"capi\"><Configurations>";
+  vs_project* project = vs_project_parse(path.c_str(), truncated, strlen(truncated));
+  ASSERT_TRUE(project != 0);
+  EXPECT_NE(Str(vs_project_errors(project)).find("malformed XML"), string::npos);
+  EXPECT_EQ(vs_configuration_count(project), 0);
+  vs_project_free(project);
+
+  project = vs_project_parse(directory.Write("bad.vcproj", "<VisualStudioProject").c_str(), 0, 0);
+  ASSERT_TRUE(project != 0);
+  EXPECT_NE(Str(vs_project_errors(project)).find("malformed XML"), string::npos);
+  vs_project_free(project);
+}
+
+} //namespace
+#endif
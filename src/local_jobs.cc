@@ -0,0 +1,85 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "precompiled.h"
+#include "local_jobs.h"
+#include "utility.h"
+
+#include <errno.h>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using std::string;
+
+namespace {
+
+string SlotPath(const string& prefix, int slot) {
+  std::ostringstream ss;
+  ss << prefix << "." << slot;
+  return ss.str();
+}
+
+int RunCommand(char* argv[]) {
+#ifdef _WIN32
+  intptr_t status = _spawnvp(_P_WAIT, argv[0], argv);
+  return status == -1 ? 1 : static_cast<int>(status);
+#else
+  pid_t pid = fork();
+  if(pid == -1) return 1;
+  if(pid == 0) {
+    execvp(argv[0], argv);
+    fprintf(stderr, "vstomake: Unable to run %s\n", argv[0]);
+    _exit(127);
+  }
+
+  int status = 0;
+  while(waitpid(pid, &status, 0) == -1) {
+    if(errno != EINTR) return 1;
+  }
+  if(WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+  return WEXITSTATUS(status);
+#endif
+}
+
+} // namespace
+
+int RunLocalJob(int slots, const string& prefix, char* argv[]) {
+  if(slots < 1) slots = 1;
+
+  // take the first free slot, otherwise queue on one of them
+  std::unique_ptr<FileLock> lock;
+  for(int i = 0; i < slots && !lock; ++i) {
+    lock.reset(new FileLock(SlotPath(prefix, i), false));
+    if(!lock->locked()) lock.reset();
+  }
+  if(!lock) {
+#ifdef _WIN32
+    int slot = _getpid() % slots;
+#else
+    int slot = getpid() % slots;
+#endif
+    lock.reset(new FileLock(SlotPath(prefix, slot)));
+  }
+
+  if(!lock->locked()) {
+    fprintf(stderr, "vstomake: Unable to lock %s\n", prefix.c_str());
+    return 1;
+  }
+  return RunCommand(argv);
+}
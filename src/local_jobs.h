@@ -0,0 +1,31 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+#include <string>
+
+// Runs a command once one of a fixed number of local job slots is
+// free and holds the slot until the command exits.
+//
+// Slots are locks on the files <prefix>.0 to <prefix>.<slots-1>, so
+// every build on the machine naming the same prefix shares them.
+// Generated Makefiles run steps that must stay on the local machine
+// through it when compiles are distributed, so a -j sized for the
+// build farm doesn't start as many links at once.
+//
+// @slots   number of commands allowed to run at once
+// @prefix  location of the slot lock files without the slot number
+// @argv    command and its arguments, terminated by a null pointer
+//
+// Returns the command's exit status, or 1 if it couldn't be run
+int RunLocalJob(int slots, const std::string& prefix, char* argv[]);
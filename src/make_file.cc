@@ -18,7 +18,14 @@
 #include "vclinkertool.h"
 #include "utility.h"
 #include "vcclcompilertool.h"
+#include "compiler_flags.h"
+#include "output_buffer.h"
+#include "string_tokenizer.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <map>
 #include <set>
+#include <iomanip>
 
 using std::ifstream;
 using std::istringstream;
@@ -30,11 +37,103 @@ using std::unordered_map;
 using std::vector;
 using std::copy_if;
 
+// Bumped whenever the generated rules change so that fragments
+// written by an older vstomake are regenerated
+static const char kGeneratorVersion[] = "vstomake-18";
 
-static string GenerateCXXFlags(const vs::VCCLCompilerTool* cl) {
+// First line of every fragment
+static const char kFingerprintPrefix[] = "# vstomake fingerprint: ";
+
+static string DirectoryOf(const string& path) {
+  size_t sep = path.find_last_of("/\\");
+  return sep == string::npos ? string("") : path.substr(0, sep+1);
+}
+
+static string FileNameOf(const string& path) {
+  size_t sep = path.find_last_of("/\\");
+  return sep == string::npos ? path : path.substr(sep+1);
+}
+
+// Returns the location of the object compiled from source. The
+// source's directory is mirrored beneath intdir and its extension
+// kept, a/x.cc becomes intdir/a/x.cc.o, so that files with the same
+// name in different directories or with different extensions get
+// distinct objects. Parent references become __ and drive letters
+// lose their colon.
+static string ObjectPath(const string& intdir, const string& source) {
+  string path(intdir);
+  string name(ToUnixPaths(StripCurrentDirReference(source)));
+
+  size_t begin = 0;
+  while(begin <= name.size()) {
+    size_t end = name.find('/', begin);
+    if(end == string::npos) end = name.size();
+    string part(name.substr(begin, end - begin));
+    if(part == "..") {
+      path.append("/__");
+    } else if(!part.empty() && part != ".") {
+      path.append("/" + Replace(part, ":", "_"));
+    }
+    begin = end + 1;
+  }
+  return path + ".o";
+}
+
+static string FingerprintLine(uint64_t fingerprint) {
+  stringstream ss;
+  ss << kFingerprintPrefix << std::hex << std::setw(16) << std::setfill('0') << fingerprint << "\n";
+  return ss.str();
+}
+
+// Returns path relative to the working directory if it lies beneath it
+static string RelativeToWorkingDirectory(const string& path) {
+  string cwd(AbsoluteFilePath("."));
+  cwd.push_back('/');
+  string unix_path(ToUnixPaths(path));
+  if(unix_path.compare(0, cwd.size(), ToUnixPaths(cwd)) == 0) {
+    return unix_path.substr(cwd.size());
+  }
+  return unix_path;
+}
+
+// Returns true if the file at path starts with the given fingerprint
+static bool HasFingerprint(const string& path, uint64_t fingerprint) {
+  ifstream fs(path.c_str());
+  string line;
+  if(!fs.is_open() || !std::getline(fs, line)) return false;
+  line.push_back('\n');
+  return line == FingerprintLine(fingerprint);
+}
+
+
+// Writes the rules that replace a file with the value of a make
+// variable while make reads the fragment, only when its contents
+// differ, so no recipe runs and the file's time stamp only moves
+// when it changes. Reading files with $(file <) requires GNU make 4.2.
+static void WriteOnRead(const string& path, const string& variable, OutputBuffer& out) {
+  string directory(path.substr(0, path.find_last_of('/')));
+  out << "ifneq ($(file < " << path << "),$(" << variable << "))\n"
+      << "$(shell mkdir -p " << directory << ")\n"
+      << "$(file > " << path << ",$(" << variable << "))\n"
+      << "endif\n";
+}
+
+// @param cl          compiler settings of the configuration
+// @param precompiled  forced include replaced by the precompiled header
+static string GenerateCXXFlags(const vs::VCCLCompilerTool* cl,
+                               const string& precompiled) {
   stringstream ss("");
-  if(strcmp(cl->ForcedIncludeFiles(), "") != 0) {
-    ss << " -include " << Replace(ToUnixPaths(cl->ForcedIncludeFiles()), ";", " -include ");
+  string codegen(CodeGenerationFlags(*cl));
+  if(!codegen.empty()) {
+    ss << " " << codegen;
+  }
+
+  StringTokenizer forced_includes(ToUnixPaths(cl->ForcedIncludeFiles()), ";");
+  while(forced_includes.next()) {
+    string header(forced_includes.token());
+    if(precompiled.empty() || FileNameOf(header) != FileNameOf(precompiled)) {
+      ss << " -include " << header;
+    }
   }
 
   if(strcmp(cl->AdditionalIncludeDirectories(), "") != 0) {
@@ -53,71 +152,206 @@ static string GenerateCPPFlags(const vs::VCCLCompilerTool* cl) {
 struct MakefileGen {
   MakefileGen() {}
 
-  MakefileGen(const vs::Project& project);
+  MakefileGen(const vs::Project& project, const MakefileOptions& options);
   void   Initialize(const vs::Configuration& config);
-  string GlobalVariables();
-  string TopLevelBuildRules();
-  string BuildPrologue();
-  string ObjectBuildRules();
-  string PreBuildRule();
-  string BuildRule();
-  string PostBuildRule();
-  string BuildEpilogue();
+  uint64_t Fingerprint() const;
+  void   GlobalVariables(OutputBuffer& out);
+  void   TopLevelBuildRules(OutputBuffer& out);
+  void   RegenerationRule(const string& basename, OutputBuffer& out);
+  void   DirectoryRules(OutputBuffer& out);
+  void   FragmentInclude(const string& fragment, OutputBuffer& out);
+  void   BuildPrologue(OutputBuffer& out);
+  void   ObjectBuildRules(OutputBuffer& out);
+  void   PreBuildRule(OutputBuffer& out);
+  void   BuildRule(OutputBuffer& out);
+  void   PostBuildRule(OutputBuffer& out);
+  void   BuildEpilogue(OutputBuffer& out);
+
+  // Location of the object compiled from a source file
+  string ObjectPath(const string& source) const;
+
+  // Name of the variable listing one group of the configuration's objects
+  string GroupObjs(size_t group) const {
+    stringstream ss;
+    ss << config_objs << "_" << group;
+    return ss.str();
+  }
+
+  // Sources compiled through a unity translation unit
+  bool UnityCandidate(const vs::File* file) const;
+
+  // Splits the configuration's sources into single_sources and units
+  void GroupSources();
+
+  // Name of the configuration's copy of a make variable
+  string Var(const char* name) const { return "$(" + rule + "_" + name + ")"; }
+
+  // Flags every source of the configuration is compiled with
+  string CompileFlags() const {
+    return Var("CPPFLAGS") + (pch.empty() ? string(" ") : " " + Var("PCHFLAGS") + " ") + Var("CXXFLAGS");
+  }
 
   vector<vs::File*> build_sources;
 
   set<string>       general_rules; //holds Debug, Release etc
   set<string>       specific_rules; //holds DebugWin32, ReleaseWin32 etc
 
-  stringstream      ss;
-
 
   string rule;
   string name;
   string outdir, intdir;
-  string config_objs, config_srcs;
+  string config_objs;
   string precompiled;
+  string pch_header, pch;
   string project_name;
   string project_dir;
+  string depdb;
+  string flags_stamp;
+  string cxxflags, cppflags;
+  string ldflags, ldlibs;
+
+  // link time optimization, see LTO_CXXFLAGS
+  bool              lto;
+  string target;
   string config_name;
   string config_platform;
 
+  // command compiles are run through, such as ccache
+  string            launcher;
+
+  // distcc or icecc when compiles are distributed
+  string            remote;
+
+  // command compiling sources and the prefix of
+  // steps that must run on this machine
+  string            compiler;
+  string            local_job;
 
+  // unity builds, a limit of 0 is unbounded
+  bool              unity;
+  size_t            unity_files;
+  uint64_t          unity_bytes;
+  set<string>       unity_exclude;
+
+  // sources compiled on their own and the unity translation units,
+  // each a unit's path paired with the sources it includes
+  vector<string>    single_sources;
+  vector<std::pair<string, vector<string> > > units;
+
+  const vs::Project*          project;
+  const MakefileOptions*      options;
   const vector<vs::File*>*    files;
   const vs::VCCLCompilerTool* cl;
+  const vs::Configuration*    config;
 
   vs::Enum::Type type;
 };
 
+bool MakefileOptions::Flag(const std::string& flag, std::string* value) const {
+  foreach(auto& f, flags) {
+    if(f.compare(0, flag.size(), flag) != 0) continue;
+    if(f.size() == flag.size() || f[flag.size()] == '=') {
+      if(value) value->assign(f.size() == flag.size() ? string("") : f.substr(flag.size()+1));
+      return true;
+    }
+  }
+  return false;
+}
+
 // TODO(wdang): look into serialization implementations
-// TODO(wdang): provide rules for static libraries
-// TODO(wdang): provide rules for shared libraries
-Makefile::Makefile(const vs::Project& project) {
-  std::stringstream ss("");
+Makefile::Makefile(const vs::Project& project, const std::string& path,
+                   const MakefileOptions& options) {
+  MakefileGen gen(project, options);
+  string directory(DirectoryOf(path));
+  string basename(path.empty() ? string("Makefile") : FileNameOf(path));
 
-  MakefileGen gen(project);
+  contents << "\n#### Build variables ####\n";
+  gen.GlobalVariables(contents);
+  contents << "\n";
 
-  ss << "\n#### Build variables ####\n"
-     << gen.GlobalVariables() << "\n";
+  contents << "\n#### Build rules ####\n";
+  gen.TopLevelBuildRules(contents);
 
-  ss << "\n#### Build rules ####\n"
-     << gen.TopLevelBuildRules();
+  contents << "#### Regeneration ####\n";
+  gen.RegenerationRule(basename, contents);
+  contents << "\n";
 
+  contents << "#### Directories ####\n";
+  gen.DirectoryRules(contents);
+  contents << "\n";
+
+  contents << "#### Configurations ####\n";
   foreach(auto& config, project.Configurations) {
     gen.Initialize(config);
-    ss << gen.BuildPrologue() << "\n"
-       << gen.ObjectBuildRules() << "\n"
-       << gen.PreBuildRule() << "\n"
-       << gen.BuildRule() << "\n"
-       << gen.PostBuildRule() << "\n"
-       << gen.BuildEpilogue() << "\n\n";
-  }
-  this->contents = ss.str();
+
+    Fragment fragment;
+    fragment.name.assign(basename + "." + gen.rule);
+    fragment.fingerprint = gen.Fingerprint();
+    gen.FragmentInclude(fragment.name, contents);
+
+    if(path.empty() || !HasFingerprint(directory + fragment.name, fragment.fingerprint)) {
+      OutputBuffer& out = fragment.contents;
+      out << FingerprintLine(fragment.fingerprint);
+      gen.BuildPrologue(out);
+      out << "\n";
+      gen.ObjectBuildRules(out);
+      out << "\n";
+      gen.PreBuildRule(out);
+      out << "\n";
+      gen.BuildRule(out);
+      out << "\n";
+      gen.PostBuildRule(out);
+      out << "\n";
+      gen.BuildEpilogue(out);
+      out << "\n\n";
+    }
+    fragments.push_back(std::move(fragment));
+  }
+}
+
+bool Makefile::Write(const std::string& path, vector<string>* written) const {
+  string directory(DirectoryOf(path));
+
+  // fragments are written before the Makefile that includes them
+  foreach(auto& fragment, fragments) {
+    if(fragment.contents.empty()) continue;
+
+    string fragment_path(directory + fragment.name);
+    bool changed = false;
+    if(!WriteFileIfChanged(fragment_path, fragment.contents, &changed)) return false;
+    if(changed && written) written->push_back(fragment_path);
+  }
+
+  // the Makefile itself only changes with the
+  // project's configuration list
+  bool changed = false;
+  if(!WriteFileIfChanged(path, contents, &changed)) return false;
+  if(changed && written) written->push_back(path);
+  return true;
 }
 
-MakefileGen::MakefileGen(const vs::Project& project)
+bool Makefile::Check(const std::string& path, vector<string>* changed) const {
+  string directory(DirectoryOf(path));
+  size_t count = changed->size();
+
+  foreach(auto& fragment, fragments) {
+    string fragment_path(directory + fragment.name);
+    if(!fragment.contents.empty() && FileContentsDiffer(fragment_path, fragment.contents)) {
+      changed->push_back(fragment_path);
+    }
+  }
+
+  if(FileContentsDiffer(path, contents)) {
+    changed->push_back(path);
+  }
+  return changed->size() != count;
+}
+
+MakefileGen::MakefileGen(const vs::Project& project, const MakefileOptions& options)
   : project_name(project.Name),
-    project_dir(ToUnixPaths(project.Path)) {
+    project_dir(ToUnixPaths(project.Path)),
+    project(&project),
+    options(&options) {
   size_t sep = project.Path.find_last_of("/\\");
   if(sep == string::npos) {
     project_dir.assign(".");
@@ -129,6 +363,43 @@ MakefileGen::MakefileGen(const vs::Project& project)
     general_rules.insert(rule.ConfigurationName);
     specific_rules.insert(rule.ConfigurationName + rule.Platform);
   }
+
+  string value;
+  launcher.assign(options.Flag("--launcher", &value) ? value : "");
+  remote.assign(options.Flag("--icecc") ? "icecc" : options.Flag("--distcc") ? "distcc" : "");
+
+  // ccache runs the distributing compiler itself through CCACHE_PREFIX
+  bool remote_prefix = !remote.empty() && FileNameOf(launcher) != "ccache";
+  compiler.assign(remote_prefix ? "$(CXX_LAUNCHER) $(CXX_REMOTE) $(CXX)" : "$(CXX_LAUNCHER) $(CXX)");
+  local_job.assign(remote.empty() ? "" : "$(LOCAL_JOB) ");
+
+  unity = false;
+  unity_files = 0;
+  unity_bytes = 0;
+  if(options.Flag("--unity-files", &value)) {
+    unity_files = strtoul(value.c_str(), 0, 10);
+    unity = true;
+  }
+  if(options.Flag("--unity-bytes", &value)) {
+    unity_bytes = strtoull(value.c_str(), 0, 10);
+    unity = true;
+  }
+  if(options.Flag("--unity-exclude", &value)) {
+    StringTokenizer names(ToUnixPaths(value), ";,");
+    while(names.next()) {
+      unity_exclude.insert(StripCurrentDirReference(names.token()));
+    }
+  }
+}
+
+// Files a FileConfiguration gives settings of their own, the
+// precompiled header's source, C sources and those named by
+// --unity-exclude are compiled on their own.
+bool MakefileGen::UnityCandidate(const vs::File* file) const {
+  if(!unity || file->ToolOverrides || file->Precompiled || file->CompileAsC) return false;
+  string path(ToUnixPaths(StripCurrentDirReference(file->RelativePath)));
+  return unity_exclude.find(path) == unity_exclude.end() &&
+         unity_exclude.find(FileNameOf(path)) == unity_exclude.end();
 }
 
 void MakefileGen::Initialize(const vs::Configuration& config) {
@@ -139,126 +410,432 @@ void MakefileGen::Initialize(const vs::Configuration& config) {
   rule.assign(config.ConfigurationName + config.Platform);
   name.assign(config.Name);
   config_objs.assign(rule + "_OBJS");
-  config_srcs.assign(rule + "_SRCS");
   files = &config.Files;
   cl    = &config.CLCompilerTool;
   type  = config.ConfigurationType;
+  this->config = &config;
   precompiled.assign("");
-
   foreach(auto& f, config.Files) {
     if(f->Precompiled) {
       precompiled.assign(ToUnixPaths(f->RelativePath));
     }
   }
+
+  // The header named by PrecompiledHeaderThrough is compiled once
+  // into the intermediate directory and reached through a stub of the
+  // same name there, which includes the real header should the
+  // compiler reject the .gch. The stub names the header with angle
+  // brackets so it is searched for in the include directories rather
+  // than beside the stub.
+  pch_header.assign("");
+  pch.assign("");
+  if(cl->UsePrecompiledHeader() == vs::VCCLCompilerTool::Enum::pchUseUsingSpecific) {
+    string through(ToUnixPaths(cl->PrecompiledHeaderThrough()));
+    if(through.empty()) through.assign("stdafx.h");
+
+    foreach(auto& f, config.Files) {
+      string path(ToUnixPaths(StripCurrentDirReference(f->RelativePath)));
+      if(FileNameOf(path) == FileNameOf(through)) {
+        pch_header.assign(path);
+        break;
+      }
+    }
+    if(pch_header.empty()) {
+      pch_header.assign(precompiled.empty() ? through : DirectoryOf(precompiled) + through);
+    }
+    pch.assign(intdir + "/" + FileNameOf(through));
+  }
+
+  depdb.assign(options->Flag("--depdb") ? intdir + "/deps.mk" : "");
+  flags_stamp.assign(intdir + "/" + rule + ".flags");
+  cxxflags.assign(GenerateCXXFlags(cl, pch));
+  cppflags.assign(GenerateCPPFlags(cl));
+  if(type == vs::Enum::Type_DynamicLibrary) {
+    cxxflags.append(" -fPIC");
+  }
+
+  // AdditionalOptions follow the structured settings as they do on
+  // MSVC's command line, less the flags those already gave
+  vector<string> unknown;
+  string additional(TranslateCompilerOptions(cl->AdditionalOptions(), &unknown));
+  string structured(cppflags + cxxflags);
+  MergeFlags(additional, &structured);
+  cxxflags.append(structured.substr(cppflags.size() + cxxflags.size()));
+  foreach(auto& option, unknown) {
+    fprintf(stderr, "vstomake: %s: ignoring compiler option %s\n", name.c_str(), option.c_str());
+  }
+
+  unknown.clear();
+  ldlibs.assign("");
+  ldflags.assign(TranslateLinkerOptions(config.LinkerTool.AdditionalOptions(), &ldlibs, &unknown));
+  foreach(auto& option, unknown) {
+    fprintf(stderr, "vstomake: %s: ignoring linker option %s\n", name.c_str(), option.c_str());
+  }
+
+  // /GL and /LTCG in AdditionalOptions ask for the same, the flags
+  // are given once through LTO_CXXFLAGS and LTO_LDFLAGS
+  lto = LinkTimeOptimization(config);
+  if(RemoveFlag("-flto", &cxxflags)) lto = true;
+  if(RemoveFlag("-flto", &ldflags))  lto = true;
+  if(lto) {
+    cxxflags.append(" $(LTO_CXXFLAGS)");
+    ldflags.append(ldflags.empty() ? "" : " ").append("$(LTO_LDFLAGS)");
+  }
+
+  switch(type) {
+    case vs::Enum::Type_Application:    target.assign("$(PROJECT_NAME)"); break;
+    case vs::Enum::Type_DynamicLibrary: target.assign("lib$(PROJECT_NAME).so"); break;
+    case vs::Enum::Type_StaticLibrary:  target.assign("lib$(PROJECT_NAME).a"); break;
+    default:                            target.assign(""); break;
+  }
+
+  GroupSources();
 }
 
-std::string MakefileGen::GlobalVariables() {
-  ss.str("");
-  ss << "CFLAGS += $(CURRENT_CFLAGS)\n"
-     << "CPPFLAGS += $(CURRENT_CPPFLAGS)\n"
-     << "CXXFLAGS += --std=gnu++0x $(CURRENT_CXXFLAGS) -I" << project_dir <<" -Wall -Wextra\n"
-     << "LDFLAGS  += $(CURRENT_LDFLAGS)\n"
-     << "ARFLAGS   = -rcs $(CURRENT_ARFLAGS)\n"
-     << "PROJECT_NAME      := " <<project_name << "\n"
-     << "OUTDIR             = $(CURRENT_OUTDIR)\n"
-     << "INTDIR             = $(CURRENT_INTDIR)\n"
-     << "TARGET             = $(CURRENT_OUTDIR)/$(CURRENT_TARGET)\n";
-  return ss.str();
+// Hash of everything a configuration's fragment is generated from
+uint64_t MakefileGen::Fingerprint() const {
+  uint64_t hash = HashString(kGeneratorVersion);
+  foreach(auto& flag, options->flags) {
+    hash = HashString(flag, hash);
+  }
+  hash = HashString(project_name, hash);
+  hash = HashString(project_dir, hash);
+  hash = HashString(name, hash);
+  hash = HashString(intdir, hash);
+  hash = HashString(outdir, hash);
+  hash = HashBytes(reinterpret_cast<const char*>(&type), sizeof(type), hash);
+  hash = HashBytes(reinterpret_cast<const char*>(&config->WholeProgramOptimization),
+                   sizeof(config->WholeProgramOptimization), hash);
+
+  // tool properties are unordered
+  vector<string> properties;
+  foreach(auto& tool, config->ToolProperties) {
+    foreach(auto& prop, tool.second) {
+      properties.push_back(tool.first + '\0' + prop.first + '\0' + prop.second);
+    }
+  }
+  std::sort(properties.begin(), properties.end());
+  foreach(auto& prop, properties) {
+    hash = HashString(prop, hash);
+  }
+
+  foreach(auto* file, *files) {
+    char flags[] = {file->Precompiled, file->CompileAsC, file->ForcedInclude, file->ToolOverrides};
+    hash = HashString(file->RelativePath, hash);
+    hash = HashBytes(flags, sizeof(flags), hash);
+  }
+
+  foreach(auto& sheet, config->PropertySheets) {
+    uint64_t sheet_hash = 0;
+    HashFile(sheet, &sheet_hash);
+    hash = HashString(sheet, hash);
+    hash = HashBytes(reinterpret_cast<const char*>(&sheet_hash), sizeof(sheet_hash), hash);
+  }
+
+  // unit membership follows the sizes of the sources with --unity-bytes
+  foreach(auto& unit, units) {
+    hash = HashString(unit.first, hash);
+    foreach(auto& path, unit.second) {
+      hash = HashString(path, hash);
+    }
+  }
+  return hash;
 }
 
-std::string MakefileGen::TopLevelBuildRules() {
-  ss.str("");
+// Every rule is explicit so make's built-in rules and variables are
+// disabled to spare it the implicit rule search. -R takes effect once
+// the Makefile is read, the tools are kept by assigning them here.
+//
+// Compiles run through $(CXX_LAUNCHER), set by --launcher. Command
+// lines only name paths relative to the project directory so a
+// compiler cache shared by checkouts in different places can hit:
+// the project directory is mapped away from __FILE__ and debug
+// information, and ccache is told to do the same to its hash.
+void MakefileGen::GlobalVariables(OutputBuffer& out) {
+  string include_dir(RelativeToWorkingDirectory(project_dir + "/"));
+  include_dir.erase(include_dir.size() - (include_dir.size() > 1 ? 1 : 0));
+  if(include_dir.empty()) include_dir.assign(".");
+
+  out << "MAKEFLAGS         += -rR\n"
+      << "MAKEFILE_DIR      := $(dir $(lastword $(MAKEFILE_LIST)))\n"
+      << "CXX               := $(CXX)\n"
+      << "CXX_LAUNCHER      ?=" << (launcher.empty() ? "" : " " + launcher) << "\n"
+      << "AR                := $(AR)\n"
+      << "CXXFLAGS += --std=gnu++0x -I" << include_dir <<" -Wall -Wextra\n";
+  if(!launcher.empty()) {
+    out << "CXXFLAGS += -ffile-prefix-map=$(abspath " << include_dir << ")/=\n";
+  }
+  if(FileNameOf(launcher) == "ccache") {
+    out << "export CCACHE_BASEDIR    := $(abspath " << include_dir << ")\n"
+        << "export CCACHE_SLOPPINESS := pch_defines,time_macros\n";
+  }
 
-  ss << "default:\n"
-     << "\t@echo Available build rules:\n";
+  // Distributed compiles share make's jobs with steps that stay on
+  // this machine, those take one of LOCAL_JOBS machine wide slots
+  // first so -j can be sized for the build farm.
+  if(!remote.empty()) {
+    out << "CXX_REMOTE        ?= " << remote << "\n"
+        << "ifndef LOCAL_JOBS\n"
+        << "LOCAL_JOBS        := $(shell nproc 2>/dev/null || echo 1)\n"
+        << "endif\n"
+        << "LOCAL_JOB          = $(VSTOMAKE) --local $(LOCAL_JOBS) $(or $(TMPDIR),/tmp)/vstomake-local-job --\n";
+    if(FileNameOf(launcher) == "ccache") {
+      out << "export CCACHE_PREFIX     := $(CXX_REMOTE)\n";
+    }
+  }
+  out << "ARFLAGS   = -rcs\n"
+      << "PROJECT_NAME      := " <<project_name << "\n";
+}
+
+void MakefileGen::TopLevelBuildRules(OutputBuffer& out) {
+  out << "default:\n"
+      << "\t$(info Available build rules:)\n";
   foreach(auto& rule, general_rules) {
-    ss << "\t@echo "  << rule << "\n";
+    out << "\t$(info "  << rule << ")\n";
   }
   foreach(auto& rule, specific_rules) {
-    ss << "\t@echo "  << rule << "\n";
+    out << "\t$(info "  << rule << ")\n";
   }
 
-  ss << "\t@echo all\n"
-     << "\t@echo clean\n"
-     << "\n.PHONY: all clean\n\nall:";
+  out << "\t$(info all)\n"
+      << "\t$(info clean)\n"
+      << "\n.PHONY: all clean\n\nall:";
 
   foreach(auto& rule, general_rules) {
-    ss <<" "<< rule;
+    out <<" "<< rule;
   }
 
   // clean rules
-  ss <<"\n\nclean: \n"
-     <<"\t@rm -vf ";
+  out <<"\n\nclean: \n"
+      <<"\t@rm -vf ";
 
   foreach(auto& name, specific_rules) {
-    ss <<"$("<< name << "_OBJS) ";
+    out <<"$("<< name << "_OBJS) $(" << name << "_OBJS:.o=.d) $(" << name << "_PCH) $("
+        << name << "_PCH:=.gch) $(" << name << "_PCH:=.gch.d) ";
+    if(unity) {
+      out << "$(" << name << "_UNITY_OBJS:.cc.o=.cc) ";
+    }
+  }
+  foreach(auto& config, project->Configurations) {
+    string config_intdir(ToUnixPaths(config.IntermediateDirectory));
+    out << config_intdir << "/" << config.ConfigurationName << config.Platform << ".flags ";
+    if(options->Flag("--depdb")) {
+      out << config_intdir << "/deps.mk " << config_intdir << "/deps.mk.log "
+          << config_intdir << "/deps.mk.lock ";
+    }
   }
-  ss <<"\n\n";
+  out <<"\n\n";
 
   foreach(auto& rule, general_rules) {
-    ss << rule << ":";
+    out << rule << ":";
     foreach(auto& name, specific_rules) {
       if(name.find(rule) != string::npos) {
-        ss <<" "<< name;
+        out <<" "<< name;
       }
     }
-    ss << "\n\n";
+    out << "\n\n";
   }
 
-  return ss.str();
 }
 
-std::string MakefileGen::BuildPrologue() {
-  ss.clear();
-  ss.str("");
-  ss << "#### Configuration: " << config_name<<" ####\n"
-     << "####      Platform: " << config_platform<<" ####\n"
-     << rule <<"_SRCS :=";
+// The Makefile depends on the project file and every property sheet.
+// When one of them is newer GNU make runs this rule before anything
+// else, then restarts with the regenerated Makefile and fragments.
+// The Makefile is touched since it is only rewritten if its
+// contents changed.
+void MakefileGen::RegenerationRule(const string& basename, OutputBuffer& out) {
+  set<string> sheets;
+  foreach(auto& config, project->Configurations) {
+    foreach(auto& sheet, config.PropertySheets) {
+      sheets.insert(RelativeToWorkingDirectory(sheet));
+    }
+  }
 
-  // source listing
-  vector<vs::File*> sources;
-  FilterCPPSources(*files, &sources);
+  out << "VSTOMAKE          ?= vstomake\n"
+      << "VSTOMAKE_FLAGS    :=";
+  foreach(auto& flag, options->flags) {
+    out << " " << flag;
+  }
 
-  foreach(auto& src, sources) {
-    ss << "\\\n"<< ToUnixPaths(StripCurrentDirReference(src->RelativePath));
+  // Without vstomake, as when building it from a fresh checkout
+  // whose project files look newer than the Makefiles, an out of date
+  // Makefile is only reported.
+  string project_file(ToUnixPaths(project->Path));
+  out << "\n\n$(MAKEFILE_DIR)" << basename << ": " << project_file;
+  foreach(auto& sheet, sheets) {
+    out << " " << sheet;
   }
+  out << "\n"
+      << "ifneq ($(shell command -v $(firstword $(VSTOMAKE)) 2>/dev/null),)\n"
+      << "\t$(VSTOMAKE) " << project_file << " $(MAKEFILE_DIR:%/=%) $(VSTOMAKE_FLAGS)\n"
+      << "\t@touch $@\n"
+      << "else\n"
+      << "\t@echo \"warning: $(VSTOMAKE) not found, $@ may be out of date with $?\" >&2\n"
+      << "endif\n";
+}
 
-  // prebuild stats
+// Output and intermediate directories of every configuration are
+// real targets. Rules name them as order-only prerequisites so they
+// exist before anything is written to them under any -j, without
+// rebuilding the contents when a directory's timestamp changes.
+// Configurations may share directories so the rules are written once.
+void MakefileGen::DirectoryRules(OutputBuffer& out) {
+  set<string> directories;
+  foreach(auto& config, project->Configurations) {
+    string config_intdir(ToUnixPaths(config.IntermediateDirectory));
+    directories.insert(config_intdir);
+    directories.insert(ToUnixPaths(config.OutputDirectory));
+
+    vector<vs::File*> sources;
+    FilterCPPSources(config.Files, &sources);
+    foreach(auto* src, sources) {
+      string object_dir(DirectoryOf(::ObjectPath(config_intdir, src->RelativePath)));
+      directories.insert(object_dir.substr(0, object_dir.size() - 1));
+    }
+  }
 
-  ss << "\n" << rule << "Stats:\n"
-     << "\t@echo \"Configuration: " << name <<"\"\n"
-     << "\t@echo \"CPPFLAGS:     \" $(CPPFLAGS)\n"
-     "\t@echo \"CFLAGS:       \" $(CFLAGS)\n"
-     "\t@echo \"CXXFLAGS:     \" $(CXXFLAGS)\n"
-     "\t@echo \"ARFLAGS:      \" $(ARFLAGS)\n"
-     "\t@echo \"LDFLAGS:      \" $(LDFLAGS)\n"
-     "\t@echo \"Intermediates:\" $(INTDIR)\n"
-     "\t@echo \"Outputs:      \" $(OUTDIR)\n"
-     "\t@echo \"Target:       \" $(TARGET)\n\n";
+  foreach(auto& directory, directories) {
+    out << directory << " ";
+  }
+  out << ":\n"
+      << "\t@mkdir -p $@\n";
+}
 
-  // source to .o pathsubst
-  string objects_o(intdir + "/%.o");
+// A fragment is only read when a goal needs its configuration: one
+// of its rules, its general configuration rule, all, clean or a file
+// beneath its directories. Running make without a goal lists the
+// rules and reads no fragments.
+void MakefileGen::FragmentInclude(const string& fragment, OutputBuffer& out) {
+  out << "ifneq ($(filter all clean " << config_name << " " << rule << "% clean." << rule
+      << " " << intdir << "/% " << outdir << "/%,$(MAKECMDGOALS)),)\n"
+      << "include $(MAKEFILE_DIR)" << fragment << "\n"
+      << "endif\n";
+}
 
-  objects_o.append("/%.o");
-  ss << this->config_objs << " := $(patsubst %.cc," << this->intdir << "/%.o,$(notdir $("<< this->config_srcs <<")))\n"
-     << this->config_objs << " := $(patsubst %.cpp,"<< this->intdir << "/%.o,$(" << this->config_objs <<"))\n"
-     << this->config_objs << " := $(patsubst %.cxx,"<< this->intdir << "/%.o,$(" << this->config_objs <<"))\n\n";
+void MakefileGen::BuildPrologue(OutputBuffer& out) {
+  out << "#### Configuration: " << config_name<<" ####\n"
+      << "####      Platform: " << config_platform<<" ####";
 
+  vector<vs::File*> sources;
+  FilterCPPSources(*files, &sources);
+
+  // Link time optimization compiles to GCC's intermediate language
+  // and optimizes across the objects when linking, in as many
+  // partitions as make has free job slots. Archives of such objects
+  // need the linker plugin's index. For ThinLTO with Clang set
+  // LTO_CXXFLAGS and LTO_LDFLAGS to -flto=thin, LTO_AR to llvm-ar and
+  // LTO_RANLIB to llvm-ranlib.
+  if(lto) {
+    out << "\nLTO_CXXFLAGS      ?= -flto\n"
+        << "LTO_LDFLAGS       ?= -flto=jobserver\n"
+        << "LTO_AR            ?= gcc-ar\n"
+        << "LTO_RANLIB        ?= gcc-ranlib";
+  }
+
+  // Each configuration binds its own copies of the flags and
+  // directories when the fragment is read, so its rules never depend
+  // on which goal pulled them in and configurations can build
+  // concurrently.
+  out << "\n" << rule << "_OUTDIR   := " << outdir << "\n"
+      << rule << "_INTDIR   := " << intdir << "\n"
+      << rule << "_CPPFLAGS := $(CPPFLAGS) " << cppflags << "\n"
+      << rule << "_CXXFLAGS := $(CXXFLAGS)" << cxxflags << "\n"
+      << rule << "_LDFLAGS  := $(LDFLAGS)" << (ldflags.empty() ? "" : " ") << ldflags << "\n"
+      << rule << "_LDLIBS   := $(LDLIBS)" << (ldlibs.empty() ? "" : " ") << ldlibs << "\n"
+      << rule << "_TARGET   := " << (target.empty() ? string("") : outdir + "/" + target) << "\n"
+      << rule << "_PCH      := " << pch << "\n";
+
+  // The precompiled header is included ahead of any other forced
+  // include, GCC only uses a .gch for the first thing a translation
+  // unit includes.
+  if(!pch.empty()) {
+    out << rule << "_PCHFLAGS := -Winvalid-pch " << (FileNameOf(launcher) == "ccache" && remote.empty() ? "-fpch-preprocess " : "")
+        << "-include " << Var("PCH") << "\n";
+  }
+
+  // prebuild stats
+  out << "\n" << rule << "Stats:\n"
+      << "\t$(info Configuration: " << name <<")\n"
+      << "\t$(info CPPFLAGS:      " << Var("CPPFLAGS") << ")\n"
+      << "\t$(info CXXFLAGS:      " << Var("CXXFLAGS") << ")\n"
+      << "\t$(info ARFLAGS:       $(ARFLAGS))\n"
+      << "\t$(info LDFLAGS:       " << Var("LDFLAGS") << ")\n"
+      << "\t$(info LDLIBS:        " << Var("LDLIBS") << ")\n"
+      << "\t$(info Intermediates: " << Var("INTDIR") << ")\n"
+      << "\t$(info Outputs:       " << Var("OUTDIR") << ")\n"
+      << "\t$(info Target:        " << Var("TARGET") << ")\n"
+      << "\t$(info Precompiled:   " << Var("PCH") << ")\n\n";
 
-  return ss.str();
 }
 
-std::string MakefileGen::ObjectBuildRules() {
-  ss.clear();
-  ss.str("");
+string MakefileGen::ObjectPath(const string& source) const {
+  return ::ObjectPath(intdir, source);
+}
 
-  std::set<string> src_paths;
-  std::stringstream forced_include("");
+void MakefileGen::GroupSources() {
+  single_sources.clear();
+  units.clear();
   vector<vs::File*> sources;
   FilterCPPSources(*files, &sources);
 
+  // unity candidates by directory
+  std::map<string, vector<string> > unity_dirs;
   foreach(auto src, sources) {
     string path(ToUnixPaths(StripCurrentDirReference(src->RelativePath)));
+    if(UnityCandidate(src)) {
+      unity_dirs[path.substr(0, path.find_last_of('/')+1)].push_back(path);
+    } else {
+      single_sources.push_back(path);
+    }
+  }
+
+  // Unity translation units only batch sources of one directory, so
+  // their quoted includes resolve as before, in path order so a unit
+  // only changes when sources next to it are added or removed. A unit
+  // is closed once it holds --unity-files sources or the next source
+  // would take it past --unity-bytes, sizes as of generation.
+  // A source left on its own is compiled as usual.
+  foreach(auto& dir, unity_dirs) {
+    std::sort(dir.second.begin(), dir.second.end());
+    vector<string> unit;
+    uint64_t bytes = 0;
+    size_t dir_units = 0;
+    auto close_unit = [&]() {
+      if(unit.size() == 1) {
+        single_sources.push_back(unit.front());
+      } else if(!unit.empty()) {
+        stringstream name;
+        name << dir.first << "vstomake_unity_" << dir_units++ << ".cc";
+        string object(ObjectPath(name.str()));
+        units.push_back(std::make_pair(object.substr(0, object.size() - 2), unit));
+      }
+      unit.clear();
+      bytes = 0;
+    };
+
+    foreach(auto& path, dir.second) {
+      uint64_t size = 0;
+      struct stat info;
+      if(unity_bytes && stat((project_dir + "/" + path).c_str(), &info) == 0) {
+        size = info.st_size;
+      }
+      if(!unit.empty() && ((unity_files && unit.size() >= unity_files) ||
+                           (unity_bytes && bytes + size > unity_bytes))) {
+        close_unit();
+      }
+      unit.push_back(path);
+      bytes += size;
+    }
+    close_unit();
+  }
+}
+
+void MakefileGen::ObjectBuildRules(OutputBuffer& out) {
+  // objects grouped by the directory and extension of their sources,
+  // each group's objects share a directory
+  std::map<string, vector<string> > src_paths;
+
+  auto add_source = [&](const string& path) {
     string path_part(path.substr(0, path.find_last_of('/')+1));
     string ext(path.substr(path.find_last_of('.')));
 
@@ -267,88 +844,188 @@ std::string MakefileGen::ObjectBuildRules() {
     src_wildcard.append(path_part);
     src_wildcard.append("%");
     src_wildcard.append(ext);
-    src_paths.insert(src_wildcard);
+    src_paths[src_wildcard].push_back(ObjectPath(path));
+  };
+
+  foreach(auto& path, single_sources) {
+    add_source(path);
   }
 
-  std::string recipe(intdir + "/%.o : ");
+  // -MMD writes the headers each object includes, forced includes
+  // and the precompiled header among them, next to the object. -MP
+  // adds an empty rule per header so deleting one doesn't break make.
+  // With --depdb the output is logged for the configuration's
+  // dependency database instead so make reads a single file.
+  string depfile("$(@:.o=.d)");
+  string dependency_flags(depdb.empty() ? "-MMD -MP" : "-MMD -MF " + depfile);
+  stringstream recipe;
+  recipe << "\t$(info $<)\n"
+         << "\t@" << compiler << " " << CompileFlags() << " " << dependency_flags
+         << " -c $< -o $@\n";
+  if(!depdb.empty()) {
+    recipe << "\t@$(VSTOMAKE) --deplog " << depdb << " " << depfile << "\n";
+  }
+  //
+  // Each group's objects are listed once, relative to their directory,
+  // and compiled by a static pattern rule so make never searches for
+  // an implicit rule. The configuration's object list joins the groups.
+  size_t group = 0;
   foreach(auto& src_wildcard, src_paths) {
-    ss << recipe << src_wildcard <<"\n"
-       << "\t@echo $<\n"
-       << "\t@$(CXX) $(CPPFLAGS) $(CXXFLAGS) -c $<"<< forced_include.str() <<" -o $(INTDIR)/$(notdir $@)\n";
+    string object_dir(DirectoryOf(src_wildcard.second.front()));
+    string group_objs(GroupObjs(group++));
+    out << group_objs << " := $(addprefix " << object_dir << ",";
+    for(size_t i = 0, end = src_wildcard.second.size(); i < end; ++i) {
+      out << (i ? " " : "") << src_wildcard.second[i].substr(object_dir.size());
+    }
+    object_dir.erase(object_dir.size() - 1);
+    string ext(src_wildcard.first.substr(src_wildcard.first.find_last_of('%') + 1));
+    out << ")\n"
+        << "$(" << group_objs << ") : " << object_dir << "/%" << ext << ".o : " << src_wildcard.first
+        << " | " << object_dir << "\n"
+        << recipe.str();
+  }
+
+  // Each unit includes its sources by their path in the project,
+  // found through the project directory's -I, and is rewritten while
+  // make reads the fragment when its sources change. Units live
+  // among the objects of their directory.
+  string unity_objs(rule + "_UNITY_OBJS");
+  for(size_t i = 0, end = units.size(); i < end; ++i) {
+    stringstream unit;
+    unit << rule << "_UNITY_" << i;
+    out << "\ndefine " << unit.str() << "\n";
+    foreach(auto& path, units[i].second) {
+      out << "#include \"" << path << "\"\n";
+    }
+    out << "endef\n";
+    WriteOnRead(units[i].first, unit.str(), out);
+  }
+  if(!units.empty()) {
+    out << unity_objs << " :=";
+    foreach(auto& unit, units) {
+      out << " " << unit.first << ".o";
+    }
+    out << "\n$(" << unity_objs << ") : %.cc.o : %.cc\n"
+        << recipe.str();
   }
 
+  out << "\n" << config_objs << " :=";
+  for(size_t i = 0; i < group; ++i) {
+    out << " $(" << GroupObjs(i) << ")";
+  }
+  if(!units.empty()) {
+    out << " $(" << unity_objs << ")";
+  }
+  out << "\n";
 
-  return ss.str();
-}
+  // The stamp holds the compiler command line and is rewritten while
+  // make reads the fragment, only when the command line changes, so
+  // objects are rebuilt exactly when the configuration's flags change
+  // without running a recipe on every build.
+  string command(rule + "_COMMAND");
+  out << "\n" << command << " := $(CXX) " << CompileFlags() << "\n";
+  WriteOnRead(flags_stamp, command, out);
+  out << "$(" << config_objs << "): " << flags_stamp << "\n";
 
-std::string MakefileGen::PreBuildRule() {
-  ss.clear();
-  ss.str("");
+  // only existing dependency files are named, make would otherwise
+  // look for a rule to create each missing one
+  if(depdb.empty()) {
+    out << "\n-include $(wildcard $(" << config_objs << ":.o=.d))\n";
+  } else {
+    // the log of this build's compiles is merged once, before the
+    // database is read
+    out << "\nifneq ($(wildcard " << depdb << ".log),)\n"
+        << "$(shell $(VSTOMAKE) --deplog " << depdb << ")\n"
+        << "endif\n"
+        << "-include " << depdb << "\n";
+  }
+
+}
 
+void MakefileGen::PreBuildRule(OutputBuffer& out) {
   // prebuild rule
-  ss << rule << "Prebuild"<< ":\n"
-     << "\t@mkdir -p " <<  intdir << "\n"
-     << "\t@mkdir -p " << outdir << "\n\n";
+  out << rule << "Prebuild"<< ": | " << intdir << " " << outdir << "\n\n";
 
-  if(!precompiled.empty()) {
-    std::string pch(precompiled.substr(0, precompiled.find_last_of(".")));
-    pch.append(".h.gch");
-    ss << pch << ":\n"
-       << "\t$(CXX) $(CPPFLAGS) $(CXXFLAGS) -c " << precompiled  << " -o " << pch << "\n";
+  // The header is compiled with exactly the flags of the objects
+  // that use it, less its own -include, so GCC accepts the .gch
+  // rather than silently parsing the header again. -Winvalid-pch
+  // reports a rejected .gch should the two ever diverge. Distributed
+  // compiles never see the .gch and read the header through the stub.
+  if(!pch.empty()) {
+    string gch(Var("PCH") + ".gch");
+    out << Var("PCH") << ": | " << intdir << "\n"
+        << "\t@echo '#include <" << pch_header << ">' > $@\n"
+        << gch << ": " << pch_header << " " << Var("PCH") << " " << flags_stamp << " | " << intdir << "\n"
+        << "\t$(info " << pch_header << ")\n"
+        << "\t@" << local_job << "$(CXX_LAUNCHER) $(CXX) " << Var("CPPFLAGS") << " " << Var("CXXFLAGS") << " -MMD " << (depdb.empty() ? "-MP " : "")
+        << "-MF $@.d -x c++-header $(" << rule << "_PCH) -o $@\n";
+    if(!depdb.empty()) {
+      out << "\t@$(VSTOMAKE) --deplog " << depdb << " $@.d\n";
+    }
+    out << "$(" << config_objs << "): " << gch << "\n";
+    if(depdb.empty()) {
+      out << "-include $(wildcard " << gch << ".d)\n";
+    }
   }
 
-  return ss.str();
 }
 
-std::string MakefileGen::BuildRule() {
-  ss.clear();
-  ss.str("");
+void MakefileGen::BuildRule(OutputBuffer& out) {
   // Main build rule
+  // The output is a real file so an up to date tree links nothing.
+  // Diagnostics are printed by the optional <rule>Stats rule.
   string build_rule(rule+"Build");
-  ss << build_rule << ":CURRENT_OUTDIR    :=" << outdir<< "\n"
-     << build_rule << ":CURRENT_INTDIR    :=" << intdir << "\n"
-     << build_rule << ":CURRENT_CXXFLAGS  :=" << GenerateCXXFlags(cl) << "\n"
-     << build_rule << ":CURRENT_CPPFLAGS  :=" << GenerateCPPFlags(cl) << "\n";
+  if(target.empty()) {
+    out << build_rule << ":\n\n";
+    return;
+  }
+
+  out << build_rule << ": " << Var("TARGET") << "\n"
+      << Var("TARGET") << ": $(" << config_objs << ") | " << outdir << "\n";
 
-  string prerequisites(rule + "Stats " + "$(" + config_objs +")");
+  // + lets the link reach make's jobserver to run LTO partitions in
+  // parallel, make also runs it under -n.
+  string link(lto ? "\t+" : "\t");
+  string flags(Var("CPPFLAGS") + " " + Var("CXXFLAGS") + " " + Var("LDFLAGS"));
   switch(type) {
     case vs::Enum::Type_Application:
-      ss << build_rule << ":CURRENT_TARGET    :=" << "$(PROJECT_NAME)\n"
-         << build_rule << ":" << prerequisites << "\n"
-         << "\t$(CXX)  $(CPPFLAGS) $(CXXFLAGS) $(LDFLAGS) "<<" $(" << config_objs << ")" << " -o $(TARGET)\n\n";
+      out << link << local_job << "$(CXX) " << flags << " $(" << config_objs << ") " << Var("LDLIBS") << " -o $@\n\n";
       break;
 
     case vs::Enum::Type_DynamicLibrary:
-      ss << build_rule << ":CURRENT_TARGET        :=" << "lib$(PROJECT_NAME).so\n"
-         << build_rule << ":" << prerequisites << "\n"
-         << "\t$(CXX) -shared $(CPPFLAGS) $(CXXFLAGS) "<<" $(" << config_objs << ")" <<" -o $(OutDir)/lib$(PROJECT_NAME).so\n\n";
+      out << link << local_job << "$(CXX) -shared " << flags << " $(" << config_objs << ") " << Var("LDLIBS") << " -o $@\n\n";
       break;
 
     case vs::Enum::Type_StaticLibrary:
-      ss << build_rule << ":CURRENT_TARGET       :=" << "lib$(PROJECT_NAME).a\n"
-         << build_rule << ":" << prerequisites << "\n"
-         << "\t$(AR) $(ARFLAGS) $(TARGET)" <<" $(" << config_objs << ")\n\n";
+      // members of removed objects would otherwise stay in the archive
+      out << "\t@rm -f $@\n"
+          << "\t" << local_job << (lto ? "$(LTO_AR)" : "$(AR)") << " $(ARFLAGS) $@" <<" $(" << config_objs << ")\n";
+      if(lto) {
+        out << "\t" << local_job << "$(LTO_RANLIB) $@\n";
+      }
+      out << "\n";
       break;
-   
-    case vs::Enum::Type_Unknown:
-    case vs::Enum::Type_Utility:
+
     default:
       break;
   }
-  return ss.str();
 }
 
-std::string MakefileGen::PostBuildRule() {
-  ss.clear();
-  ss.str("");
-  ss << rule << ": " << rule << "Prebuild " << rule << "Build ";
-  return ss.str();
+void MakefileGen::PostBuildRule(OutputBuffer& out) {
+  out << ".PHONY: " << rule << " " << rule << "Prebuild " << rule << "Build " << rule << "Stats\n"
+      << rule << ": " << rule << "Prebuild " << rule << "Build ";
 }
 
-std::string MakefileGen::BuildEpilogue() {
-  ss.clear();
-  ss.str("");
-  ss << "clean." << rule << ":\n\t"
-     <<"@rm -vf $("<<config_objs << ")";
-  return ss.str();
+void MakefileGen::BuildEpilogue(OutputBuffer& out) {
+  out << "clean." << rule << ":\n\t"
+      <<"@rm -vf $("<<config_objs << ") $(" << config_objs << ":.o=.d) " << flags_stamp;
+  if(!pch.empty()) {
+    out << " " << pch << " " << pch << ".gch " << pch << ".gch.d";
+  }
+  if(unity) {
+    out << " $(" << rule << "_UNITY_OBJS:.cc.o=.cc)";
+  }
+  if(!depdb.empty()) {
+    out << " " << depdb << " " << depdb << ".log " << depdb << ".lock";
+  }
 }
@@ -13,14 +13,70 @@
 // limitations under the License.
 #pragma once
 #include <string>
+#include <vector>
+#include "output_buffer.h"
 
 namespace vs {struct Project;}
 
+// Generation settings given on the vstomake command line
+struct MakefileOptions {
+  // vstomake flags (--flag or --flag=value) that are passed
+  // along when the generated Makefile regenerates itself
+  std::vector<std::string> flags;
+
+  // Returns true if flag (e.g. --depdb) was given
+  //
+  // @value  optional, receives the text following '='
+  bool Flag(const std::string& flag, std::string* value = 0) const;
+};
+
 struct Makefile {
+  // Each configuration's rules are written to a separate file
+  // included by the Makefile. A fragment carries a fingerprint of
+  // everything it was generated from so that it is only regenerated
+  // and rewritten when one of those inputs changes.
+  struct Fragment {
+    // file name relative to the Makefile's directory
+    std::string name;
+
+    // hash of the configuration's tool data, file membership
+    // and property sheets
+    uint64_t    fingerprint;
+
+    // empty if the fragment on disk is up to date
+    OutputBuffer contents;
+  };
+
   // Construct a Makefile representation of a vcproj
   // using the given VCProj object and
   //
-  // The resulting Makefile.contents
-  explicit Makefile(const vs::Project& project);
-  std::string contents;
+  // @project  parsed project
+  // @path     location the Makefile will be written to, existing
+  //           fragments next to it are reused when up to date
+  // @options  generation settings
+  //
+  // The resulting Makefile.contents depends on the project file and
+  // its property sheets and reruns vstomake when either changes.
+  explicit Makefile(const vs::Project& project, const std::string& path = "",
+                    const MakefileOptions& options = MakefileOptions());
+
+  // Write the Makefile to path along with every regenerated fragment.
+  // Files whose contents would not change are left untouched.
+  //
+  // @path     location of the Makefile
+  // @written  optional list of the files that were written
+  //
+  // Returns true on success
+  bool Write(const std::string& path, std::vector<std::string>* written = 0) const;
+
+  // Collect the files Write would change without writing anything.
+  //
+  // @path     location of the Makefile
+  // @changed  list of the files that are missing or out of date
+  //
+  // Returns true if any file would change
+  bool Check(const std::string& path, std::vector<std::string>* changed) const;
+
+  OutputBuffer contents;
+  std::vector<Fragment> fragments;
 };
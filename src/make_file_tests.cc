@@ -0,0 +1,127 @@
+#ifdef VSTOMAKE_RUN_TESTS
+#include "make_file.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include "libvs.h"
+#include "test_utility.h"
+
+namespace {
+using std::string;
+
+// The project whose sources are batched into unity units
+TestProject UnityProject() {
+  TestProject project("unity");
+  project.Configuration("Debug", "IntermediateDirectory=\"obj\"")
+         .File("a/one.cc")
+         .File("a/two.cc")
+         .File("a/three.cc")
+         .File("b/only.cc");
+  return project;
+}
+
+// MakefileTest Test fixture.
+class MakefileTest : public ::testing::Test {
+protected:
+
+  // Called before each test(after the constructor).
+  virtual void SetUp() {
+    ASSERT_FALSE(Directory.path.empty());
+    Directory.MakeDirectory("a");
+    Directory.MakeDirectory("b");
+    Directory.Write("a/one.cc", string(100, ' '));
+    Directory.Write("a/two.cc", string(100, ' '));
+    Directory.Write("a/three.cc", string(100, ' '));
+    Directory.Write("b/only.cc", string(100, ' '));
+  }
+
+  // Generates the Makefile of project with the given flag, the
+  // configuration's fragment is kept in Fragment
+  uint64_t Generate(const string& flag, const TestProject& source = UnityProject()) {
+    vs::Project project;
+    EXPECT_EQ(ParseTestProject(Directory, source, &project), "");
+
+    MakefileOptions options;
+    options.flags.push_back(flag);
+    Makefile makefile(project, "", options);
+    EXPECT_EQ(makefile.fragments.size(), 1);
+    if(makefile.fragments.empty()) return 0;
+    Fragment = makefile.fragments[0].contents.str();
+    return makefile.fragments[0].fingerprint;
+  }
+
+  // Returns the sources each unity unit of Fragment includes, units
+  // separated by '|'
+  string Units() const {
+    string units;
+    size_t pos = 0;
+    while((pos = Fragment.find("\ndefine DebugWin32_UNITY_", pos)) != string::npos) {
+      size_t end = Fragment.find("endef\n", pos);
+      pos = Fragment.find('\n', pos + 1) + 1;
+      units.append(units.empty() ? "" : "|");
+      while(pos < end) {
+        size_t line_end = Fragment.find('\n', pos);
+        string line(Fragment.substr(pos, line_end - pos));
+        units.append(line.substr(strlen("#include \""), line.size() - strlen("#include \"\"")));
+        units.append(" ");
+        pos = line_end + 1;
+      }
+    }
+    return units;
+  }
+
+  TempDirectory Directory;
+  string Fragment;
+};
+
+TEST_F(MakefileTest, UnityFiles) {
+  Generate("--unity-files=2");
+  // b/only.cc is alone in its directory and a/two.cc left over
+  EXPECT_EQ(Units(), "a/one.cc a/three.cc ");
+  EXPECT_NE(Fragment.find("only.cc.o"), string::npos);
+  EXPECT_NE(Fragment.find("two.cc.o"), string::npos);
+  EXPECT_EQ(Fragment.find("one.cc.o"), string::npos);
+
+  Generate("--unity-files=3");
+  EXPECT_EQ(Units(), "a/one.cc a/three.cc a/two.cc ");
+}
+
+TEST_F(MakefileTest, UnityBytes) {
+  Generate("--unity-bytes=250");
+  EXPECT_EQ(Units(), "a/one.cc a/three.cc ");
+
+  Generate("--unity-bytes=300");
+  EXPECT_EQ(Units(), "a/one.cc a/three.cc a/two.cc ");
+
+  // a source larger than the limit is compiled on its own
+  Directory.Write("a/three.cc", string(400, ' '));
+  Generate("--unity-bytes=300");
+  EXPECT_EQ(Units(), "");
+}
+
+TEST_F(MakefileTest, UnityFingerprint) {
+  uint64_t fingerprint = Generate("--unity-bytes=300");
+  EXPECT_EQ(Generate("--unity-bytes=300"), fingerprint);
+
+  // a size change that keeps the units keeps the fragment
+  Directory.Write("a/two.cc", string(90, ' '));
+  EXPECT_EQ(Generate("--unity-bytes=300"), fingerprint);
+
+  Directory.Write("a/two.cc", string(150, ' '));
+  EXPECT_NE(Generate("--unity-bytes=300"), fingerprint);
+  EXPECT_EQ(Units(), "a/one.cc a/three.cc ");
+}
+
+TEST_F(MakefileTest, SameNameSources) {
+  // a/x.cc and a/x.cpp share a directory and a name
+  Directory.Write("a/x.cc", "");
+  Directory.Write("a/x.cpp", "");
+  Generate("", UnityProject().File("a/x.cc").File("a/x.cpp"));
+  EXPECT_NE(Fragment.find(" : obj/a/%.cc.o : a/%.cc | obj/a\n"), string::npos);
+  EXPECT_NE(Fragment.find(" : obj/a/%.cpp.o : a/%.cpp | obj/a\n"), string::npos);
+  EXPECT_NE(Fragment.find("x.cc.o"), string::npos);
+  EXPECT_NE(Fragment.find("x.cpp.o"), string::npos);
+  EXPECT_EQ(Fragment.find("x.o"), string::npos);
+}
+
+} //namespace
+#endif
@@ -88,6 +88,10 @@ bool MSBuildParser::Parse( const std::string& ){
   return false;
 }
 
+bool MSBuildParser::Parse(const std::string&, const char*, size_t) {
+  return false;
+}
+
 bool MSBuildParser::Configurations(vector<vs::Configuration>* out) {
   if(!project || !project->first_node("ItemGroup"))
     return false;
@@ -112,6 +116,7 @@ bool MSBuildParser::Configurations(vector<vs::Configuration>* out) {
   while(project_configuration) {
     XMLAttribute* include = project_configuration->first_attribute("Include");
     vs::Configuration config;
+    config.WholeProgramOptimization = vs::Enum::Optimization_None;
     config.Name.assign(include ? include->value() : "");
 
     XMLNode* node = project_configuration->first_node("Configuration");
@@ -155,8 +160,13 @@ bool MSBuildParser::Files(vector<vs::File>* files) {
       if(XMLAttribute* include = cinclude->first_attribute("Include")) {
         vs::File file;
         file.RelativePath.assign(include->value());
-        file.Precompiled = cinclude->first_node("PrecompiledHeader") != 0;
-        file.Precompiled = cinclude->first_node("ExcludedFromBuild") != 0;
+        file.ForcedInclude = false;
+        file.Precompiled = false;
+        file.CompileAsC = false;
+        file.ToolOverrides = false;
+        if(XMLNode* pch = cinclude->first_node("PrecompiledHeader")) {
+          file.Precompiled = strcmp(pch->value(), "Create") == 0;
+        }
         files->push_back(file);
       }
     }
@@ -23,6 +23,7 @@ struct MSBuildParser : public ProjectParser {
   virtual bool Parse(char* buffer, size_t len);
   virtual bool ProjectProperties( std::unordered_map<std::string, std::string>* props );
   virtual bool Parse(const std::string& path);
+  virtual bool Parse(const std::string& path, const char* buffer, size_t len);
 
 private:
   std::unordered_map<std::string, std::string> macros;
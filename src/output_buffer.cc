@@ -0,0 +1,78 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "precompiled.h"
+#include "output_buffer.h"
+#include "utility.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define write _write
+#else
+#include <unistd.h>
+#endif
+
+using std::string;
+
+bool OutputBuffer::Equals(const char* data, size_t len) const {
+  if(len != length) return false;
+  for(size_t i = 0, end = chunks.size(); i < end; ++i) {
+    size_t count = 0;
+    const char* bytes = chunk(i, &count);
+    if(memcmp(bytes, data, count) != 0) return false;
+    data += count;
+  }
+  return true;
+}
+
+string OutputBuffer::str() const {
+  string rv;
+  rv.reserve(length);
+  for(size_t i = 0, end = chunks.size(); i < end; ++i) {
+    size_t count = 0;
+    const char* bytes = chunk(i, &count);
+    rv.append(bytes, count);
+  }
+  return rv;
+}
+
+bool OutputBuffer::WriteTo(int fd) const {
+  for(size_t i = 0, end = chunks.size(); i < end; ++i) {
+    size_t count = 0;
+    const char* bytes = chunk(i, &count);
+    while(count) {
+      int written = write(fd, bytes, static_cast<unsigned>(count));
+      if(written <= 0) return false;
+      bytes += written;
+      count -= written;
+    }
+  }
+  return true;
+}
+
+bool FileContentsDiffer(const string& path, const OutputBuffer& buffer) {
+  string existing("");
+  if(!FileToString(path, &existing)) return true;
+  return !buffer.Equals(existing.data(), existing.size());
+}
+
+bool WriteFileIfChanged(const string& path, const OutputBuffer& buffer, bool* changed) {
+  if(changed) *changed = false;
+  if(!FileContentsDiffer(path, buffer)) return true;
+
+  if(!WriteFileAtomically(path, [&buffer](int fd) { return buffer.WriteTo(fd); })) {
+    return false;
+  }
+  if(changed) *changed = true;
+  return true;
+}
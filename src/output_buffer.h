@@ -0,0 +1,125 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Append-only text buffer made of fixed size chunks.
+//
+// Appending never moves text that was already written, so generating
+// large outputs costs one copy into the buffer and one write to the
+// file descriptor, instead of the repeated reallocation and copying
+// of concatenated strings.
+//
+// usage pattern:
+// OutputBuffer out;
+// out << "all: " << target << '\n';
+// out.WriteTo(fd);
+struct OutputBuffer {
+  static const size_t kChunkSize = 64 * 1024;
+
+  OutputBuffer() : length(0) {}
+
+  OutputBuffer(OutputBuffer&& other)
+    : chunks(std::move(other.chunks)),
+      length(other.length) {
+    other.length = 0;
+  }
+
+  OutputBuffer& operator=(OutputBuffer&& other) {
+    chunks = std::move(other.chunks);
+    length = other.length;
+    other.length = 0;
+    return *this;
+  }
+
+  void Append(const char* data, size_t len) {
+    while(len) {
+      size_t used = length % kChunkSize;
+      if(used == 0 && length / kChunkSize == chunks.size()) {
+        chunks.push_back(std::unique_ptr<char[]>(new char[kChunkSize]));
+      }
+
+      size_t count = kChunkSize - used < len ? kChunkSize - used : len;
+      memcpy(chunks.back().get() + used, data, count);
+      data   += count;
+      len    -= count;
+      length += count;
+    }
+  }
+
+  OutputBuffer& operator<<(const std::string& str) {
+    Append(str.data(), str.size());
+    return *this;
+  }
+
+  OutputBuffer& operator<<(const char* str) {
+    Append(str, strlen(str));
+    return *this;
+  }
+
+  OutputBuffer& operator<<(char c) {
+    Append(&c, 1);
+    return *this;
+  }
+
+  // total number of bytes appended
+  size_t size() const { return length; }
+  bool empty() const { return length == 0; }
+
+  size_t chunk_count() const { return chunks.size(); }
+
+  // Returns the start of the given chunk and its byte length in len
+  const char* chunk(size_t index, size_t* len) const {
+    bool last = index + 1 == chunks.size();
+    *len = last && length % kChunkSize ? length % kChunkSize : kChunkSize;
+    return chunks[index].get();
+  }
+
+  // Returns true if the buffer holds the given bytes
+  bool Equals(const char* data, size_t len) const;
+
+  // Returns a copy of the contents as a single string
+  std::string str() const;
+
+  // Write the contents to the file descriptor fd.
+  //
+  // Returns true on success
+  bool WriteTo(int fd) const;
+
+ private:
+  OutputBuffer(const OutputBuffer&);
+  OutputBuffer& operator=(const OutputBuffer&);
+
+  std::vector<std::unique_ptr<char[]> > chunks;
+  size_t length;
+};
+
+// Returns true if the file at path is missing or its
+// contents differ from the given buffer
+bool FileContentsDiffer(const std::string& path, const OutputBuffer& buffer);
+
+// Same as WriteFileIfChanged in utility.h for the contents of a buffer,
+// which is written straight to the temporary file's descriptor.
+//
+// @path: location of the file
+// @buffer: new contents of the file
+// @changed: optional, set to true if the file was written
+//
+// Returns true on success
+bool WriteFileIfChanged(const std::string& path, const OutputBuffer& buffer,
+                        bool* changed = 0);
@@ -0,0 +1,184 @@
+#ifdef VSTOMAKE_RUN_TESTS
+#include "output_buffer.h"
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <algorithm>
+#include "test_utility.h"
+#include "utility.h"
+
+#ifdef _WIN32
+#define open  _open
+#define close _close
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+namespace {
+using std::string;
+
+const size_t kChunkSize = OutputBuffer::kChunkSize;
+
+// Returns size bytes of text that differs from chunk to chunk
+string Text(size_t size) {
+  string text;
+  text.reserve(size);
+  for(size_t i = 0; i < size; ++i) {
+    text.push_back(static_cast<char>('a' + (i * 7 + i / kChunkSize) % 26));
+  }
+  return text;
+}
+
+// Appends text to out in pieces of the given size
+void AppendPieces(const string& text, size_t piece, OutputBuffer* out) {
+  for(size_t i = 0; i < text.size(); i += piece) {
+    out->Append(text.data() + i, std::min(piece, text.size() - i));
+  }
+}
+
+// Returns the contents out writes to a file descriptor
+string Written(const OutputBuffer& out) {
+  TempDirectory directory;
+  EXPECT_FALSE(directory.path.empty());
+  string path(directory.Path("written"));
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+  EXPECT_NE(fd, -1);
+  EXPECT_TRUE(out.WriteTo(fd));
+  close(fd);
+
+  string contents;
+  EXPECT_TRUE(FileToString(path, &contents));
+  return contents;
+}
+
+TEST(OutputBufferTest, Empty) {
+  OutputBuffer out;
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(out.size(), 0);
+  EXPECT_EQ(out.chunk_count(), 0);
+  EXPECT_EQ(out.str(), "");
+  EXPECT_TRUE(out.Equals("", 0));
+  EXPECT_FALSE(out.Equals("a", 1));
+  EXPECT_EQ(Written(out), "");
+
+  out << "";
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(out.chunk_count(), 0);
+}
+
+TEST(OutputBufferTest, CrossesChunks) {
+  // pieces that don't divide the chunk size straddle each boundary
+  string text(Text(3 * kChunkSize + 17));
+  OutputBuffer out;
+  AppendPieces(text, 1000, &out);
+
+  EXPECT_EQ(out.size(), text.size());
+  ASSERT_EQ(out.chunk_count(), 4);
+  size_t offset = 0;
+  for(size_t i = 0; i < out.chunk_count(); ++i) {
+    size_t len = 0;
+    const char* chunk = out.chunk(i, &len);
+    EXPECT_EQ(len, i < 3 ? kChunkSize : 17);
+    EXPECT_EQ(string(chunk, len), text.substr(offset, len));
+    offset += len;
+  }
+  EXPECT_EQ(out.str(), text);
+  EXPECT_TRUE(out.Equals(text.data(), text.size()));
+
+  string changed(text);
+  changed[kChunkSize] = '!';
+  EXPECT_FALSE(out.Equals(changed.data(), changed.size()));
+  EXPECT_FALSE(out.Equals(text.data(), text.size() - 1));
+}
+
+TEST(OutputBufferTest, ChunkBoundary) {
+  string text(Text(2 * kChunkSize));
+  OutputBuffer out;
+  out.Append(text.data(), kChunkSize - 1);
+  out << text[kChunkSize - 1];
+  ASSERT_EQ(out.chunk_count(), 1);
+  size_t len = 0;
+  out.chunk(0, &len);
+  EXPECT_EQ(len, kChunkSize);
+
+  // a single write spanning a whole chunk
+  out.Append(text.data() + kChunkSize, kChunkSize);
+  EXPECT_EQ(out.chunk_count(), 2);
+  EXPECT_EQ(out.str(), text);
+
+  out << "tail";
+  EXPECT_EQ(out.chunk_count(), 3);
+  EXPECT_EQ(out.str(), text + "tail");
+}
+
+TEST(OutputBufferTest, WriteTo) {
+  string text(Text(2 * kChunkSize + 5));
+  OutputBuffer out;
+  AppendPieces(text, 333, &out);
+  EXPECT_EQ(Written(out), text);
+
+  OutputBuffer small;
+  small << "all: " << string("target") << '\n';
+  EXPECT_EQ(Written(small), "all: target\n");
+}
+
+TEST(OutputBufferTest, Move) {
+  string text(Text(kChunkSize + 1));
+  OutputBuffer out;
+  AppendPieces(text, 4096, &out);
+
+  OutputBuffer moved(std::move(out));
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(moved.str(), text);
+
+  out = std::move(moved);
+  EXPECT_TRUE(moved.empty());
+  EXPECT_EQ(out.str(), text);
+}
+
+TEST(OutputBufferTest, WriteFileIfChanged) {
+  TempDirectory directory;
+  ASSERT_FALSE(directory.path.empty());
+  string path(directory.Path("Makefile"));
+  string text(Text(kChunkSize + 100));
+  OutputBuffer out;
+  AppendPieces(text, 1024, &out);
+
+  bool changed = false;
+  EXPECT_TRUE(WriteFileIfChanged(path, out, &changed));
+  EXPECT_TRUE(changed);
+  EXPECT_FALSE(FileContentsDiffer(path, out));
+  EXPECT_TRUE(WriteFileIfChanged(path, out, &changed));
+  EXPECT_FALSE(changed);
+
+  OutputBuffer empty;
+  EXPECT_TRUE(FileContentsDiffer(path, empty));
+  EXPECT_TRUE(WriteFileIfChanged(path, empty, &changed));
+  EXPECT_TRUE(changed);
+  string contents;
+  EXPECT_TRUE(FileToString(path, &contents));
+  EXPECT_EQ(contents, "");
+}
+
+TEST(OutputBufferTest, WriteFileIfChangedTemporary) {
+  // the contents go through a uniquely named temporary file, never a
+  // fixed name another writer could be using
+  TempDirectory directory;
+  ASSERT_FALSE(directory.path.empty());
+  string path(directory.Path("Makefile"));
+  directory.Write("Makefile.tmp", "other writer");
+  OutputBuffer out;
+  out << "all:\n";
+  EXPECT_TRUE(WriteFileIfChanged(path, out));
+
+  string contents;
+  EXPECT_TRUE(FileToString(directory.Path("Makefile.tmp"), &contents));
+  EXPECT_EQ(contents, "other writer");
+  contents.clear();
+  EXPECT_TRUE(FileToString(path, &contents));
+  EXPECT_EQ(contents, "all:\n");
+}
+
+} //namespace
+#endif
@@ -1,6 +1,12 @@
 #include "precompiled.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <iostream>
 #include "output_option.h"
+#include "compiler_flags.h"
 #include "internal.h"
+#include "project_cache.h"
+#include "string_tokenizer.h"
 #include "utility.h"
 
 using std::string;
@@ -42,61 +48,125 @@ bool ParseCommandLine(const vector<string>& args, unordered_map<string, string>*
 
 unordered_map<string, string> Macros;
 
+// Options in the order they are printed
+static const struct {
+  OutputOption option;
+  const char*  name;
+} kOutputOptions[] = {
+  {OutputOption_ForcedIncludes, "-i"},
+  {OutputOption_IncludeDirs,    "-I"},
+  {OutputOption_Libraries,      "-l"},
+  {OutputOption_LibraryDirs,    "-L"},
+  {OutputOption_Defines,        "-D"},
+  {OutputOption_Sources,        "-s"},
+};
 
+// Expands the macros listed in the documentation's [macros] section
+void ExpandPrefix(const vs::Project& project, const vs::Configuration& config, string* prefix) {
+  if(prefix->empty()) return;
+  Replace(prefix, "$(Name)", project.Name);
+  Replace(prefix, "$(Platform)", config.Platform);
+  Replace(prefix, "$(Configuration)", config.ConfigurationName);
+  Replace(prefix, "$(IntDir)", config.IntermediateDirectory);
+  Replace(prefix, "$(OutDir)", config.OutputDirectory);
+}
 
+// Appends each token of the delimited list to values
+// prepended with the given flag
+void AppendTokens(const string& list, const char* delimiters, const char* flag,
+                  vector<string>* values) {
+  StringTokenizer tok(list, delimiters);
+  while(tok.next()) {
+    string token(tok.token());
+    Replace(&token, "\"", "");
+    if(token.empty()) continue;
+    values->push_back(flag + token);
+  }
+}
 
-void OutputForConfiguration(const vs::Configuration& config, OutputOption flags, unordered_map<string, string>& options) {
-  std::ostringstream ss;
-  if(flags & OutputOption_ForcedIncludes) {
-    ss << options["-include"];
-    ss << "Not implemented";    
-    ss << '\n';
-  }
-
-  if(flags & OutputOption_IncludeDirs) {
-    ss << options["-I"];
-    std::string include_dirs("-I");
-    include_dirs.append(config.CLCompilerTool.AdditionalIncludeDirectories());
-    Replace(&include_dirs, ";", " -I");
-    ss <<include_dirs << '\n';
-  }
-
-  if(flags & OutputOption_Libraries) {
-    ss << options["-l"];
-    ss << "Not implemented";
-    ss << '\n';
-  }
-
-  if(flags & OutputOption_LibraryDirs) {
-    ss << options["-L"];
-    ss << "Not implemented";
-    ss << '\n';
-  }
-
-  if(flags & OutputOption_Defines) {
-    ss << options["-D"];
-    std::string defines("-D");
-    defines.append(config.CLCompilerTool.PreprocessorDefinitions());
-    Replace(&defines, ";", " -D");
-    ss <<defines << '\n';
-  }
-
-  if(flags & OutputOption_Sources) {
-    ss << options["-s"];
-    vector<vs::File*> sources;
-    sources.reserve(config.Files.size());
-    vs::FilterCPPSources(config.Files, &sources);
-    for(size_t i = 0, end = sources.size(); i < end; ++i) {
-      const std::string& src = ToUnixPaths(sources[i]->RelativePath);
-      if(i+1 != end) {
-        ss<<src << "\\\n";
-      } else {
-        ss<<src;
+// Appends the linker inputs as the flags that link them, the same
+// flags the generated link line gives the inputs of AdditionalOptions.
+//
+// @directories  when set, appends the -L directories the flags search
+//               instead
+void AppendLibraries(const string& list, bool directories, vector<string>* values) {
+  StringTokenizer tok(list, " \t");
+  while(tok.next()) {
+    string input(tok.token());
+    Replace(&input, "\"", "");
+    if(input.empty()) continue;
+
+    string directory;
+    string library(LibraryFlag(input, &directory));
+    if(!directories && !library.empty()) {
+      values->push_back(library);
+    } else if(directories && !directory.empty() &&
+              std::find(values->begin(), values->end(), "-L" + directory) == values->end()) {
+      values->push_back("-L" + directory);
+    }
+  }
+}
+
+// Collects the values of a single output option for the given
+// configuration
+void OptionValues(const vs::Configuration& config, OutputOption option,
+                  vector<string>* values) {
+  const vs::VCCLCompilerTool& cl   = config.CLCompilerTool;
+  const vs::VCLinkerTool& linker   = config.LinkerTool;
+  switch(option) {
+    case OutputOption_ForcedIncludes:
+      AppendTokens(ToUnixPaths(cl.ForcedIncludeFiles()), ";,", "-include ", values);
+      break;
+    case OutputOption_IncludeDirs:
+      AppendTokens(ToUnixPaths(cl.AdditionalIncludeDirectories()), ";,", "-I", values);
+      break;
+    case OutputOption_Libraries:
+      AppendLibraries(linker.AdditionalDependencies(), false, values);
+      break;
+    case OutputOption_LibraryDirs:
+      AppendTokens(ToUnixPaths(linker.AdditionalLibraryDirectories()), ";,", "-L", values);
+      AppendLibraries(linker.AdditionalDependencies(), true, values);
+      break;
+    case OutputOption_Defines:
+      AppendTokens(cl.PreprocessorDefinitions(), ";", "-D", values);
+      break;
+    case OutputOption_Sources: {
+      vector<vs::File*> sources;
+      sources.reserve(config.Files.size());
+      vs::FilterCPPSources(config.Files, &sources);
+      foreach(auto* src, sources) {
+        values->push_back(ToUnixPaths(src->RelativePath));
       }
+      break;
     }
+    default:
+      break;
   }
+}
 
-  printf(ss.str().c_str());
+string Join(const vector<string>& values, const char* separator) {
+  std::ostringstream ss;
+  for(size_t i = 0, end = values.size(); i < end; ++i) {
+    if(i) ss << separator;
+    ss << values[i];
+  }
+  return ss.str();
+}
+
+void OutputForConfiguration(const vs::Configuration& config, OutputOption flags, unordered_map<string, string>& options) {
+  std::ostringstream ss;
+  foreach(auto& o, kOutputOptions) {
+    if(!(flags & o.option)) continue;
+
+    vector<string> values;
+    OptionValues(config, o.option, &values);
+
+    // sources are listed one per line as a make variable continuation
+    const char* separator = o.option == OutputOption_Sources ? "\\\n" : " ";
+    ss << options[o.name] << Join(values, separator) << '\n';
+  }
+
+  fputs(ss.str().c_str(), stdout);
 }
 
 
@@ -146,29 +216,138 @@ void DoOutputOption(const vs::Project& project, int argc, char** argv) {
     foreach(const vs::Configuration& c, project.Configurations) {
       unordered_map<string, string> expanded = options;
       foreach(auto& m, expanded) {
-        string prefix(m.second);
-        if(!prefix.empty()) {
-          Replace(&prefix, "$(Name)", project.Name);
-          Replace(&prefix, "$(Platform)", c.Platform);
-          Replace(&prefix, "$(Configuration)", c.ConfigurationName);
-          Replace(&prefix, "$(IntDir)", c.IntermediateDirectory);
-          Replace(&prefix, "$(OutDir)", c.OutputDirectory);
-        }
-        expanded[m.first] = prefix;
+        ExpandPrefix(project, c, &m.second);
       }
       OutputForConfiguration(c, (OutputOption)flags, expanded);
     }
   } else {
     foreach(auto& o, options) {
-      string replacement(o.second);
-      Replace(&replacement, "$(Name)", project.Name);
-      Replace(&replacement, "$(Platform)", config_ptr->Platform);
-      Replace(&replacement, "$(Configuration)", config_ptr->ConfigurationName);
-      Replace(&replacement, "$(IntDir)", config_ptr->IntermediateDirectory);
-      Replace(&replacement, "$(OutDir)", config_ptr->OutputDirectory);
-      options[o.first] = replacement;
+      ExpandPrefix(project, *config_ptr, &o.second);
     }
 
     OutputForConfiguration(*config_ptr, (OutputOption)flags, options);
   }
 }
+
+
+bool OutputOptionValues(const vs::Configuration& config, const string& option,
+                        string* values) {
+  foreach(auto& o, kOutputOptions) {
+    if(option != o.name) continue;
+
+    vector<string> list;
+    OptionValues(config, o.option, &list);
+    values->assign(Join(list, " "));
+    return true;
+  }
+  return false;
+}
+
+ProjectQueries::ProjectQueries(bool use_cache) : use_cache(use_cache) {}
+
+const vs::Project* ProjectQueries::Load(const string& path, string* errors) {
+  struct stat info;
+  if(stat(path.c_str(), &info) != 0 || !(info.st_mode & S_IFREG)) {
+    errors->assign("Non existant file: " + path);
+    return 0;
+  }
+
+  // modification times miss edits within their resolution
+  auto iter = projects.find(path);
+  if(iter != projects.end() &&
+     iter->second.sources_hash == ProjectSourcesHash(iter->second.project)) {
+    return &iter->second.project;
+  }
+
+  Entry& entry = projects[path];
+  entry = Entry();
+  if(use_cache) {
+    ParseProjectCached(path, &entry.project, errors);
+  } else {
+    vs::Project::Parse(path, &entry.project, errors);
+  }
+
+  if(!errors->empty()) {
+    projects.erase(path);
+    return 0;
+  }
+  entry.sources_hash = ProjectSourcesHash(entry.project);
+  return &entry.project;
+}
+
+bool ProjectQueries::Answer(const string& path, const string& config_name,
+                            const string& option, const string& prefix,
+                            string* answer) {
+  OutputOption flag = OutputOption_Invalid;
+  foreach(auto& o, kOutputOptions) {
+    if(option == o.name) flag = o.option;
+  }
+  if(flag == OutputOption_Invalid) {
+    answer->assign("invalid option " + option);
+    return false;
+  }
+
+  string errors;
+  const vs::Project* project = Load(path, &errors);
+  if(!project) {
+    Replace(&errors, "\n", " ");
+    answer->assign(errors);
+    return false;
+  }
+
+  bool output_all = config_name == "-a";
+  bool matched    = false;
+  vector<string> answers;
+  foreach(const vs::Configuration& c, project->Configurations) {
+    if(!output_all && config_name != c.Name) continue;
+
+    vector<string> values;
+    OptionValues(c, flag, &values);
+
+    string expanded(prefix);
+    ExpandPrefix(*project, c, &expanded);
+    if(!values.empty() || !expanded.empty())
+      answers.push_back(expanded + Join(values, " "));
+    matched = true;
+  }
+
+  if(!matched) {
+    answer->assign(config_name + " is not a valid configuration name.");
+    return false;
+  }
+  answer->assign(Join(answers, " "));
+  return true;
+}
+
+void DoQueryMode(bool use_cache, std::istream& in, std::ostream& out) {
+  ProjectQueries queries(use_cache);
+  string line;
+  while(std::getline(in, line)) {
+    if(!line.empty() && line[line.size()-1] == '\r')
+      line.erase(line.size()-1);
+    if(line.empty()) continue;
+
+    // <project>\t<configuration>\t<option>[=prefix]
+    size_t first  = line.find('\t');
+    size_t second = first == string::npos ? first : line.find('\t', first+1);
+    if(second == string::npos) {
+      out << "error: expected <project>\\t<configuration>\\t<option>" << std::endl;
+      continue;
+    }
+
+    string option(line.substr(second+1));
+    string prefix("");
+    size_t index = option.find('=');
+    if(index != string::npos) {
+      prefix = option.substr(index+1);
+      option.erase(index);
+    }
+
+    string answer;
+    if(!queries.Answer(line.substr(0, first), line.substr(first+1, second-first-1),
+                       option, prefix, &answer)) {
+      answer.insert(0, "error: ");
+    }
+    out << answer << std::endl;
+  }
+}
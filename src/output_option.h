@@ -1,4 +1,67 @@
 #pragma once
+#include <stdint.h>
+#include <iosfwd>
 #include "libvs.h"
 
 void DoOutputOption(const vs::Project& project, int argc,char* argv[]);
+
+// Collects the values of an output option for a configuration.
+//
+// @config  configuration to query
+// @option  one of -i -I -l -L -D -s
+// @values  the option's values separated by spaces
+//
+// Returns false if option is not a valid output option
+bool OutputOptionValues(const vs::Configuration& config, const std::string& option,
+                        std::string* values);
+
+// Answers output option queries against projects that are parsed
+// once and kept in memory. A project is only parsed again when the
+// contents of its file or of one of its property sheets change, see
+// ProjectSourcesHash.
+struct ProjectQueries {
+  // @use_cache  read and refresh the parsed project cache
+  explicit ProjectQueries(bool use_cache);
+
+  // Returns the values of an output option for a configuration
+  // of the project at path.
+  //
+  // @path         location of the project file
+  // @config_name  configuration name or -a for every configuration
+  // @option       one of -i -I -l -L -D -s
+  // @prefix       prepended to the values, may contain [macros]
+  // @answer       the prefix and values separated by spaces, or an
+  //               error message
+  //
+  // Returns false on error
+  bool Answer(const std::string& path, const std::string& config_name,
+              const std::string& option, const std::string& prefix,
+              std::string* answer);
+
+ private:
+  struct Entry {
+    vs::Project project;
+    uint64_t    sources_hash;
+  };
+
+  const vs::Project* Load(const std::string& path, std::string* errors);
+
+  std::unordered_map<std::string, Entry> projects;
+  bool use_cache;
+};
+
+// Answers output option queries read from in until end of input.
+//
+// Each line names a project, a configuration (or -a for every
+// configuration) and an option with an optional prefix, separated
+// by tabs:
+//   vstomake.vcproj<TAB>Debug|Win32<TAB>-D=$(Configuration)_DEFINES :=
+//
+// Each query is answered with exactly one line on out holding the
+// prefix followed by the option's values separated by spaces, or a
+// line starting with "error: ".
+//
+// @use_cache  read and refresh the parsed project cache
+// @in         queries, usually stdin
+// @out        answers, flushed after each one, usually stdout
+void DoQueryMode(bool use_cache, std::istream& in, std::ostream& out);
@@ -0,0 +1,139 @@
+#ifdef VSTOMAKE_RUN_TESTS
+#include "output_option.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <sstream>
+#include "libvs.h"
+#include "test_utility.h"
+
+namespace {
+using std::string;
+
+// The queried project with the given Release defines
+TestProject QueryProject(const string& release_defines = "NDEBUG") {
+  TestProject project("query");
+  project.Configuration("Debug", "InheritedPropertySheets=\"common.vsprops\"")
+         .Tool("VCCLCompilerTool",
+               "PreprocessorDefinitions=\"_DEBUG;WIN32\" ForcedIncludeFiles=\"pre.h\"")
+         .Tool("VCLinkerTool",
+               "AdditionalDependencies=\"foo.lib ..\\third\\bar.lib kernel32.lib libz.a\" "
+               "AdditionalLibraryDirectories=\"lib;..\\lib\"")
+         .Configuration("Release")
+         .Tool("VCCLCompilerTool", "PreprocessorDefinitions=\"" + release_defines + "\"")
+         .File("main.cc")
+         .File("src/util.cpp")
+         .File("util.h");
+  return project;
+}
+
+const char kPropertySheet[] =
+  "<?xml version=\"1.0\" encoding=\"Windows-1252\"?>\n"
+  "<VisualStudioPropertySheet ProjectType=\"Visual C++\" Version=\"8.00\" Name=\"common\">\n"
+  "  <Tool Name=\"VCCLCompilerTool\" AdditionalIncludeDirectories=\"include;..\\shared\"/>\n"
+  "</VisualStudioPropertySheet>\n";
+
+// OutputOptionTest Test fixture.
+class OutputOptionTest : public ::testing::Test {
+protected:
+
+  // Called before each test(after the constructor).
+  virtual void SetUp() {
+    ASSERT_FALSE(Directory.path.empty());
+    ProjectPath = QueryProject().Write(Directory);
+    Directory.Write("common.vsprops", kPropertySheet);
+  }
+
+  // Returns the answers to the given queries, one per line
+  string Query(const string& queries) {
+    std::istringstream in(queries);
+    std::ostringstream out;
+    DoQueryMode(false, in, out);
+    return out.str();
+  }
+
+  TempDirectory Directory;
+  string ProjectPath;
+};
+
+TEST_F(OutputOptionTest, Values) {
+  vs::Project project;
+  vs::Project::Parse(ProjectPath, &project);
+  ASSERT_EQ(project.Configurations.size(), 2);
+  const vs::Configuration& debug = project.Configurations[0];
+
+  string values;
+  EXPECT_TRUE(OutputOptionValues(debug, "-D", &values));
+  EXPECT_EQ(values, "-D_DEBUG -DWIN32");
+  EXPECT_TRUE(OutputOptionValues(debug, "-I", &values));
+  EXPECT_EQ(values, "-Iinclude -I../shared");
+  EXPECT_TRUE(OutputOptionValues(debug, "-i", &values));
+  EXPECT_EQ(values, "-include pre.h");
+  EXPECT_TRUE(OutputOptionValues(debug, "-l", &values));
+  EXPECT_EQ(values, "-lfoo -lbar -l:libz.a");
+  EXPECT_TRUE(OutputOptionValues(debug, "-L", &values));
+  EXPECT_EQ(values, "-Llib -L../lib -L../third");
+  EXPECT_TRUE(OutputOptionValues(debug, "-s", &values));
+  EXPECT_EQ(values, "./main.cc ./src/util.cpp");
+
+  EXPECT_TRUE(OutputOptionValues(project.Configurations[1], "-I", &values));
+  EXPECT_EQ(values, "");
+  EXPECT_FALSE(OutputOptionValues(debug, "-x", &values));
+}
+
+TEST_F(OutputOptionTest, QueryMode) {
+  string queries(
+    ProjectPath + "\tDebug|Win32\t-D\n" +
+    ProjectPath + "\tRelease|Win32\t-D=$(Configuration)_DEFINES := \r\n" +
+    "\n" +
+    ProjectPath + "\t-a\t-D\n" +
+    ProjectPath + "\tDebug|Win32\t-x\n" +
+    ProjectPath + "\tProfile|Win32\t-D\n" +
+    Directory.Path("missing.vcproj") + "\tDebug|Win32\t-D\n" +
+    "no tabs\n");
+
+  std::istringstream answers(Query(queries));
+  string line;
+  std::getline(answers, line);
+  EXPECT_EQ(line, "-D_DEBUG -DWIN32");
+  std::getline(answers, line);
+  EXPECT_EQ(line, "Release_DEFINES := -DNDEBUG");
+  std::getline(answers, line);
+  EXPECT_EQ(line, "-D_DEBUG -DWIN32 -DNDEBUG");
+  std::getline(answers, line);
+  EXPECT_EQ(line, "error: invalid option -x");
+  std::getline(answers, line);
+  EXPECT_EQ(line, "error: Profile|Win32 is not a valid configuration name.");
+  std::getline(answers, line);
+  EXPECT_EQ(line.compare(0, 7, "error: "), 0);
+  std::getline(answers, line);
+  EXPECT_EQ(line, "error: expected <project>\\t<configuration>\\t<option>");
+  EXPECT_FALSE(std::getline(answers, line));
+}
+
+TEST_F(OutputOptionTest, PropertySheetChanged) {
+  ProjectQueries queries(false);
+  string answer;
+  EXPECT_TRUE(queries.Answer(ProjectPath, "Debug|Win32", "-I", "", &answer));
+  EXPECT_EQ(answer, "-Iinclude -I../shared");
+
+  // within the same second as the first answer
+  string sheet(kPropertySheet);
+  sheet.replace(sheet.find("include;"), strlen("include;"), "headers;");
+  Directory.Write("common.vsprops", sheet);
+  EXPECT_TRUE(queries.Answer(ProjectPath, "Debug|Win32", "-I", "", &answer));
+  EXPECT_EQ(answer, "-Iheaders -I../shared");
+}
+
+TEST_F(OutputOptionTest, ProjectChanged) {
+  ProjectQueries queries(false);
+  string answer;
+  EXPECT_TRUE(queries.Answer(ProjectPath, "Release|Win32", "-D", "", &answer));
+  EXPECT_EQ(answer, "-DNDEBUG");
+
+  QueryProject("NDEBUG;FAST").Write(Directory);
+  EXPECT_TRUE(queries.Answer(ProjectPath, "Release|Win32", "-D", "", &answer));
+  EXPECT_EQ(answer, "-DNDEBUG -DFAST");
+}
+
+} //namespace
+#endif
@@ -0,0 +1,521 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "precompiled.h"
+#include "project_cache.h"
+#include "libvs.h"
+#include "utility.h"
+
+#include <set>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char     kCacheMagic[8] = {'V', 'S', 'M', 'C', 'A', 'C', 'H', 'E'};
+const uint32_t kCacheVersion  = 4;
+const size_t   kCacheAlign    = 8;
+
+enum CacheFileFlags {
+  CacheFile_ForcedInclude = 1,
+  CacheFile_Precompiled   = 2,
+  CacheFile_CompileAsC    = 4,
+  CacheFile_ToolOverrides = 8,
+};
+
+// {offset, count} pair addressing either a string of count bytes
+// or an array of count records relative to the start of the cache
+struct CacheRef {
+  uint32_t offset;
+  uint32_t count;
+};
+
+struct CacheHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t size;
+  CacheRef path;      // project path as given to Parse
+  CacheRef directory; // working directory at parse time
+  CacheRef sources;   // CacheSource[], project file first
+  CacheRef project;   // CacheProject[1]
+};
+
+// A file the cached project was built from
+struct CacheSource {
+  CacheRef path;
+  uint32_t padding;
+  uint32_t exists;
+  uint64_t hash;
+};
+
+struct CacheFile {
+  CacheRef name;
+  CacheRef relative_path;
+  CacheRef absolute_path;
+  CacheRef excluded; // CacheRef[]
+  uint32_t flags;
+  uint32_t padding;
+};
+
+struct CacheProperty {
+  CacheRef key;
+  CacheRef value;
+};
+
+struct CacheTool {
+  CacheRef name;
+  CacheRef properties; // CacheProperty[]
+};
+
+struct CacheConfiguration {
+  CacheRef name;
+  CacheRef configuration_name;
+  CacheRef intermediate_directory;
+  CacheRef output_directory;
+  CacheRef platform;
+  CacheRef property_sheets; // CacheRef[]
+  CacheRef tools;           // CacheTool[]
+  int32_t  character_set;
+  int32_t  configuration_type;
+  int32_t  use_of_atl;
+  int32_t  use_of_mfc;
+  int32_t  whole_program_optimization;
+  int32_t  padding;
+};
+
+struct CacheProject {
+  CacheRef files;          // CacheFile[]
+  CacheRef platforms;      // CacheRef[]
+  CacheRef configurations; // CacheConfiguration[]
+  CacheRef absolute_path;
+  CacheRef name;
+  CacheRef path;
+  CacheRef project_type;
+  CacheRef project_guid;
+  CacheRef root_namespace;
+  CacheRef keyword;
+  CacheRef target_framework_version;
+  CacheRef project_directory;
+  CacheRef project_file;
+  CacheRef version;
+};
+
+// Appends records and strings to a flat buffer.
+// References returned by At() are invalidated by the next append
+// so values must be computed before they are stored.
+struct CacheWriter {
+  CacheWriter() : buffer(sizeof(CacheHeader), '\0') {}
+
+  template<class T>
+  CacheRef Array(size_t count) {
+    CacheRef ref = {Append(count * sizeof(T)), static_cast<uint32_t>(count)};
+    return ref;
+  }
+
+  CacheRef String(const string& str) {
+    CacheRef ref = {Append(str.size()), static_cast<uint32_t>(str.size())};
+    std::copy(str.begin(), str.end(), buffer.begin() + ref.offset);
+    return ref;
+  }
+
+  CacheRef Strings(const vector<string>& strings) {
+    CacheRef ref = Array<CacheRef>(strings.size());
+    for(size_t i = 0, end = strings.size(); i < end; ++i) {
+      CacheRef str = String(strings[i]);
+      At<CacheRef>(ref, i) = str;
+    }
+    return ref;
+  }
+
+  template<class T>
+  T& At(CacheRef ref, size_t index) {
+    return reinterpret_cast<T*>(&buffer[ref.offset])[index];
+  }
+
+  CacheHeader& Header() {
+    return *reinterpret_cast<CacheHeader*>(&buffer[0]);
+  }
+
+  vector<char> buffer;
+
+ private:
+  uint32_t Append(size_t bytes) {
+    size_t offset = buffer.size();
+    size_t padded = (bytes + kCacheAlign - 1) & ~(kCacheAlign - 1);
+    buffer.resize(offset + padded, '\0');
+    return static_cast<uint32_t>(offset);
+  }
+};
+
+// Bounds checked access to a mapped cache
+struct CacheReader {
+  CacheReader(const char* data, size_t size) : data(data), size(size) {}
+
+  template<class T>
+  const T* Array(CacheRef ref) const {
+    uint64_t end = static_cast<uint64_t>(ref.offset) + uint64_t(ref.count) * sizeof(T);
+    if(end > size || ref.offset % kCacheAlign) return 0;
+    return reinterpret_cast<const T*>(data + ref.offset);
+  }
+
+  bool String(CacheRef ref, string* out) const {
+    if(static_cast<uint64_t>(ref.offset) + ref.count > size) return false;
+    out->assign(data + ref.offset, ref.count);
+    return true;
+  }
+
+  bool Strings(CacheRef ref, vector<string>* out) const {
+    const CacheRef* refs = Array<CacheRef>(ref);
+    if(!refs) return false;
+    out->resize(ref.count);
+    for(uint32_t i = 0; i < ref.count; ++i) {
+      if(!String(refs[i], &(*out)[i])) return false;
+    }
+    return true;
+  }
+
+  const char* data;
+  size_t      size;
+};
+
+// Read-only view of a whole file, memory mapped where available
+struct MappedFile {
+  explicit MappedFile(const string& path) : data(0), size(0) {
+#ifdef _WIN32
+    if(FileToString(path, &contents)) {
+      data = contents.data();
+      size = contents.size();
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd == -1) return;
+    struct stat info;
+    if(fstat(fd, &info) == 0 && info.st_size > 0) {
+      void* ptr = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(ptr != MAP_FAILED) {
+        data = static_cast<const char*>(ptr);
+        size = static_cast<size_t>(info.st_size);
+      }
+    }
+    close(fd);
+#endif
+  }
+
+  ~MappedFile() {
+#ifndef _WIN32
+    if(data) munmap(const_cast<char*>(data), size);
+#endif
+  }
+
+  const char* data;
+  size_t      size;
+
+ private:
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+#ifdef _WIN32
+  string contents;
+#endif
+};
+
+// Files a parsed project depends on: the project itself followed
+// by each distinct property sheet
+vector<string> ProjectSources(const vs::Project& project) {
+  vector<string> sources(1, project.Path);
+  set<string> seen;
+  foreach(auto& config, project.Configurations) {
+    foreach(auto& sheet, config.PropertySheets) {
+      if(seen.insert(sheet).second) {
+        sources.push_back(sheet);
+      }
+    }
+  }
+  return sources;
+}
+
+bool ReadFile(const CacheReader& reader, const CacheFile& record, vs::File* file) {
+  file->ForcedInclude = (record.flags & CacheFile_ForcedInclude) != 0;
+  file->Precompiled   = (record.flags & CacheFile_Precompiled) != 0;
+  file->CompileAsC    = (record.flags & CacheFile_CompileAsC) != 0;
+  file->ToolOverrides = (record.flags & CacheFile_ToolOverrides) != 0;
+  return reader.String(record.name, &file->Name) &&
+         reader.String(record.relative_path, &file->RelativePath) &&
+         reader.String(record.absolute_path, &file->AbsolutePath) &&
+         reader.Strings(record.excluded, &file->Excluded);
+}
+
+bool ReadConfiguration(const CacheReader& reader, const CacheConfiguration& record,
+                       vs::Configuration* config) {
+  config->CharacterSet             = static_cast<vs::Enum::CharSet>(record.character_set);
+  config->ConfigurationType        = static_cast<vs::Enum::Type>(record.configuration_type);
+  config->UseOfATL                 = static_cast<vs::Enum::UseATL>(record.use_of_atl);
+  config->UseOfMfc                 = static_cast<vs::Enum::UseMfc>(record.use_of_mfc);
+  config->WholeProgramOptimization = static_cast<vs::Enum::Optimization>(record.whole_program_optimization);
+
+  if(!reader.String(record.name, &config->Name) ||
+     !reader.String(record.configuration_name, &config->ConfigurationName) ||
+     !reader.String(record.intermediate_directory, &config->IntermediateDirectory) ||
+     !reader.String(record.output_directory, &config->OutputDirectory) ||
+     !reader.String(record.platform, &config->Platform) ||
+     !reader.Strings(record.property_sheets, &config->PropertySheets)) {
+    return false;
+  }
+
+  const CacheTool* tools = reader.Array<CacheTool>(record.tools);
+  if(!tools) return false;
+
+  for(uint32_t i = 0; i < record.tools.count; ++i) {
+    string name;
+    const CacheProperty* props = reader.Array<CacheProperty>(tools[i].properties);
+    if(!props || !reader.String(tools[i].name, &name)) return false;
+
+    auto& properties = config->ToolProperties[name];
+    for(uint32_t j = 0; j < tools[i].properties.count; ++j) {
+      string key, value;
+      if(!reader.String(props[j].key, &key) || !reader.String(props[j].value, &value)) {
+        return false;
+      }
+      properties.insert(std::make_pair(key, value));
+    }
+  }
+  return true;
+}
+
+bool ReadProject(const CacheReader& reader, const CacheProject& record, vs::Project* project) {
+  if(!reader.String(record.absolute_path, &project->AbsolutePath) ||
+     !reader.String(record.name, &project->Name) ||
+     !reader.String(record.path, &project->Path) ||
+     !reader.String(record.project_type, &project->ProjectType) ||
+     !reader.String(record.project_guid, &project->ProjectGUID) ||
+     !reader.String(record.root_namespace, &project->RootNamespace) ||
+     !reader.String(record.keyword, &project->Keyword) ||
+     !reader.String(record.target_framework_version, &project->TargetFrameworkVersion) ||
+     !reader.String(record.project_directory, &project->ProjectDirectory) ||
+     !reader.String(record.project_file, &project->ProjectFile) ||
+     !reader.String(record.version, &project->Version) ||
+     !reader.Strings(record.platforms, &project->Platforms)) {
+    return false;
+  }
+
+  const CacheFile* files = reader.Array<CacheFile>(record.files);
+  const CacheConfiguration* configs = reader.Array<CacheConfiguration>(record.configurations);
+  if(!files || !configs) return false;
+
+  project->Files.resize(record.files.count);
+  for(uint32_t i = 0; i < record.files.count; ++i) {
+    if(!ReadFile(reader, files[i], &project->Files[i])) return false;
+  }
+
+  project->Configurations.resize(record.configurations.count);
+  for(uint32_t i = 0; i < record.configurations.count; ++i) {
+    if(!ReadConfiguration(reader, configs[i], &project->Configurations[i])) return false;
+  }
+  return true;
+}
+
+CacheRef WriteConfiguration(CacheWriter& writer, const vs::Configuration& config) {
+  CacheConfiguration record;
+  memset(&record, 0, sizeof(record));
+  record.name                       = writer.String(config.Name);
+  record.configuration_name         = writer.String(config.ConfigurationName);
+  record.intermediate_directory     = writer.String(config.IntermediateDirectory);
+  record.output_directory           = writer.String(config.OutputDirectory);
+  record.platform                   = writer.String(config.Platform);
+  record.property_sheets            = writer.Strings(config.PropertySheets);
+  record.character_set              = config.CharacterSet;
+  record.configuration_type         = config.ConfigurationType;
+  record.use_of_atl                 = config.UseOfATL;
+  record.use_of_mfc                 = config.UseOfMfc;
+  record.whole_program_optimization = config.WholeProgramOptimization;
+
+  record.tools = writer.Array<CacheTool>(config.ToolProperties.size());
+  size_t index = 0;
+  foreach(auto& tool, config.ToolProperties) {
+    CacheTool tool_record;
+    tool_record.name       = writer.String(tool.first);
+    tool_record.properties = writer.Array<CacheProperty>(tool.second.size());
+
+    size_t prop_index = 0;
+    foreach(auto& prop, tool.second) {
+      CacheProperty prop_record;
+      prop_record.key   = writer.String(prop.first);
+      prop_record.value = writer.String(prop.second);
+      writer.At<CacheProperty>(tool_record.properties, prop_index++) = prop_record;
+    }
+    writer.At<CacheTool>(record.tools, index++) = tool_record;
+  }
+
+  CacheRef ref = writer.Array<CacheConfiguration>(1);
+  writer.At<CacheConfiguration>(ref, 0) = record;
+  return ref;
+}
+
+} // namespace
+
+uint64_t ProjectSourcesHash(const vs::Project& project) {
+  uint64_t hash = HashString("");
+  foreach(auto& source, ProjectSources(project)) {
+    uint64_t contents = 0;
+    char exists = HashFile(source, &contents);
+    hash = HashString(source, hash);
+    hash = HashBytes(&exists, sizeof(exists), hash);
+    hash = HashBytes(reinterpret_cast<const char*>(&contents), sizeof(contents), hash);
+  }
+  return hash;
+}
+
+string ProjectCachePath(const string& path) {
+  return path + ".cache";
+}
+
+bool LoadProjectCache(const string& cache_path, const string& path, vs::Project* ptr) {
+  MappedFile file(cache_path);
+  if(!file.data || file.size < sizeof(CacheHeader)) return false;
+
+  CacheReader reader(file.data, file.size);
+  const CacheHeader& header = *reinterpret_cast<const CacheHeader*>(file.data);
+  if(memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+     header.version != kCacheVersion || header.size != file.size) {
+    return false;
+  }
+
+  // the model depends on the path the project was parsed with
+  // since relative paths and $(ProjectDir) are expanded from it
+  string cached_path, cached_directory;
+  if(!reader.String(header.path, &cached_path) || cached_path != path ||
+     !reader.String(header.directory, &cached_directory) ||
+     cached_directory != AbsoluteFilePath(".")) {
+    return false;
+  }
+
+  const CacheSource* sources = reader.Array<CacheSource>(header.sources);
+  if(!sources || header.sources.count == 0) return false;
+
+  for(uint32_t i = 0; i < header.sources.count; ++i) {
+    string source;
+    uint64_t hash = 0;
+    if(!reader.String(sources[i].path, &source)) return false;
+
+    bool exists = HashFile(source, &hash);
+    if(exists != (sources[i].exists != 0) || hash != sources[i].hash) return false;
+  }
+
+  const CacheProject* record = reader.Array<CacheProject>(header.project);
+  if(!record || header.project.count != 1) return false;
+
+  vs::Project project;
+  if(!ReadProject(reader, *record, &project)) return false;
+
+  *ptr = std::move(project);
+  vs::Project::Resolve(ptr);
+  return true;
+}
+
+bool SaveProjectCache(const string& cache_path, const vs::Project& project) {
+  CacheWriter writer;
+
+  CacheRef path      = writer.String(project.Path);
+  CacheRef directory = writer.String(AbsoluteFilePath("."));
+
+  vector<string> source_paths(ProjectSources(project));
+  CacheRef sources = writer.Array<CacheSource>(source_paths.size());
+  for(size_t i = 0, end = source_paths.size(); i < end; ++i) {
+    CacheSource source;
+    memset(&source, 0, sizeof(source));
+    source.path   = writer.String(source_paths[i]);
+    source.exists = HashFile(source_paths[i], &source.hash);
+    writer.At<CacheSource>(sources, i) = source;
+  }
+
+  CacheProject record;
+  memset(&record, 0, sizeof(record));
+  record.absolute_path            = writer.String(project.AbsolutePath);
+  record.name                     = writer.String(project.Name);
+  record.path                     = writer.String(project.Path);
+  record.project_type             = writer.String(project.ProjectType);
+  record.project_guid             = writer.String(project.ProjectGUID);
+  record.root_namespace           = writer.String(project.RootNamespace);
+  record.keyword                  = writer.String(project.Keyword);
+  record.target_framework_version = writer.String(project.TargetFrameworkVersion);
+  record.project_directory        = writer.String(project.ProjectDirectory);
+  record.project_file             = writer.String(project.ProjectFile);
+  record.version                  = writer.String(project.Version);
+  record.platforms                = writer.Strings(project.Platforms);
+
+  record.files = writer.Array<CacheFile>(project.Files.size());
+  for(size_t i = 0, end = project.Files.size(); i < end; ++i) {
+    const vs::File& file = project.Files[i];
+    CacheFile file_record;
+    file_record.name          = writer.String(file.Name);
+    file_record.relative_path = writer.String(file.RelativePath);
+    file_record.absolute_path = writer.String(file.AbsolutePath);
+    file_record.excluded      = writer.Strings(file.Excluded);
+    file_record.padding       = 0;
+    file_record.flags         = (file.ForcedInclude ? CacheFile_ForcedInclude : 0) |
+                                (file.Precompiled ? CacheFile_Precompiled : 0) |
+                                (file.CompileAsC ? CacheFile_CompileAsC : 0) |
+                                (file.ToolOverrides ? CacheFile_ToolOverrides : 0);
+    writer.At<CacheFile>(record.files, i) = file_record;
+  }
+
+  // configurations are written out of line, so collect
+  // their offsets before laying out the array
+  vector<CacheRef> configs;
+  foreach(auto& config, project.Configurations) {
+    configs.push_back(WriteConfiguration(writer, config));
+  }
+
+  record.configurations = writer.Array<CacheConfiguration>(configs.size());
+  for(size_t i = 0, end = configs.size(); i < end; ++i) {
+    CacheConfiguration config = writer.At<CacheConfiguration>(configs[i], 0);
+    writer.At<CacheConfiguration>(record.configurations, i) = config;
+  }
+
+  CacheRef project_ref = writer.Array<CacheProject>(1);
+  writer.At<CacheProject>(project_ref, 0) = record;
+
+  CacheHeader& header = writer.Header();
+  memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version   = kCacheVersion;
+  header.size      = static_cast<uint32_t>(writer.buffer.size());
+  header.path      = path;
+  header.directory = directory;
+  header.sources   = sources;
+  header.project   = project_ref;
+
+  return WriteFileAtomically(cache_path, &writer.buffer[0], writer.buffer.size());
+}
+
+bool ParseProjectCached(const string& filepath, vs::Project* ptr, string* errors) {
+  string cache_path(ProjectCachePath(filepath));
+  if(LoadProjectCache(cache_path, filepath, ptr)) {
+    return true;
+  }
+
+  vs::Project::Parse(filepath, ptr, errors);
+  if(errors->empty()) {
+    SaveProjectCache(cache_path, *ptr);
+  }
+  return false;
+}
@@ -0,0 +1,67 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+#include <stdint.h>
+#include <string>
+
+// On-disk cache of parsed projects.
+//
+// A cache file holds a fully resolved vs::Project in a flat binary
+// layout where every string and array is addressed by an offset
+// from the start of the file, so it is loaded by mapping the file
+// and copying the records out without any text parsing.
+//
+// Each cache is keyed by the path the project was parsed with, the
+// working directory and the content hashes of the project file and
+// every property sheet its configurations inherit. A mismatch on any
+// of them causes the cache to be ignored and rewritten.
+
+namespace vs {struct Project;}
+
+// Returns the location of the cache file for the project at path
+std::string ProjectCachePath(const std::string& path);
+
+// Load a cached project.
+//
+// @cache_path  location of the cache file
+// @path        project path the cache must have been created with
+// @ptr         pointer to user allocated Project structure
+//
+// Returns false if the cache is missing, malformed or stale.
+bool LoadProjectCache(const std::string& cache_path, const std::string& path,
+                      vs::Project* ptr);
+
+// Hashes the contents of a parsed project's file and of every
+// property sheet its configurations inherit, the files its cache is
+// checked against. A missing file hashes differently from an empty
+// one.
+//
+// @project  parsed project
+uint64_t ProjectSourcesHash(const vs::Project& project);
+
+// Write the given parsed project to cache_path.
+//
+// Returns true on success
+bool SaveProjectCache(const std::string& cache_path, const vs::Project& project);
+
+// Same as vs::Project::Parse but consults the project's cache first
+// and refreshes it after a successful parse.
+//
+// @filepath  location of the project file
+// @ptr       pointer to user allocated Project structure
+// @errors    pointer to user allocated string to hold error messages
+//
+// Returns true if ptr was loaded from the cache
+bool ParseProjectCached(const std::string& filepath, vs::Project* ptr,
+                        std::string* errors);
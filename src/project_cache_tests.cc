@@ -0,0 +1,122 @@
+#ifdef VSTOMAKE_RUN_TESTS
+#include "project_cache.h"
+#include <gtest/gtest.h>
+#include "libvs.h"
+#include "test_utility.h"
+#include "utility.h"
+
+namespace {
+using std::string;
+
+// The cached project, attributes are added to its configuration
+TestProject CachedProject(const string& attributes = "") {
+  TestProject project("cached");
+  project.Configuration("Debug", "InheritedPropertySheets=\"common.vsprops\"" +
+                                 (attributes.empty() ? "" : " " + attributes))
+         .Tool("VCCLCompilerTool", "PreprocessorDefinitions=\"_DEBUG\"")
+         .File("main.cc");
+  return project;
+}
+
+const char kPropertySheet[] =
+  "<?xml version=\"1.0\" encoding=\"Windows-1252\"?>\n"
+  "<VisualStudioPropertySheet ProjectType=\"Visual C++\" Version=\"8.00\" Name=\"common\">\n"
+  "  <Tool Name=\"VCCLCompilerTool\" AdditionalIncludeDirectories=\"include\"/>\n"
+  "</VisualStudioPropertySheet>\n";
+
+// ProjectCacheTest Test fixture.
+class ProjectCacheTest : public ::testing::Test {
+protected:
+
+  // Called before each test(after the constructor).
+  virtual void SetUp() {
+    ASSERT_FALSE(Directory.path.empty());
+    ProjectPath = CachedProject().Write(Directory);
+    Directory.Write("common.vsprops", kPropertySheet);
+    CachePath = ProjectCachePath(ProjectPath);
+  }
+
+  // Returns true if parsing the project was answered by its cache
+  bool Cached() {
+    vs::Project project;
+    string errors;
+    bool cached = ParseProjectCached(ProjectPath, &project, &errors);
+    EXPECT_EQ(errors, "");
+    EXPECT_EQ(project.Configurations.size(), 1);
+    if(!project.Configurations.empty()) {
+      EXPECT_STREQ(project.Configurations[0].CLCompilerTool.PreprocessorDefinitions(), "_DEBUG");
+    }
+    return cached;
+  }
+
+  TempDirectory Directory;
+  string ProjectPath;
+  string CachePath;
+};
+
+TEST_F(ProjectCacheTest, Hit) {
+  EXPECT_FALSE(Cached());
+  EXPECT_TRUE(Cached());
+  EXPECT_TRUE(Cached());
+}
+
+TEST_F(ProjectCacheTest, RoundTrip) {
+  vs::Project parsed;
+  vs::Project::Parse(ProjectPath, &parsed);
+  ASSERT_TRUE(SaveProjectCache(CachePath, parsed));
+
+  vs::Project loaded;
+  ASSERT_TRUE(LoadProjectCache(CachePath, ProjectPath, &loaded));
+  EXPECT_EQ(loaded.Name, "cached");
+  ASSERT_EQ(loaded.Files.size(), parsed.Files.size());
+  ASSERT_EQ(loaded.Configurations.size(), 1);
+  EXPECT_EQ(loaded.Configurations[0].PropertySheets, parsed.Configurations[0].PropertySheets);
+  EXPECT_STREQ(loaded.Configurations[0].CLCompilerTool.AdditionalIncludeDirectories(), "include");
+  EXPECT_EQ(loaded.Configurations[0].Files.size(), 1);
+}
+
+TEST_F(ProjectCacheTest, ProjectChanged) {
+  EXPECT_FALSE(Cached());
+  CachedProject("CharacterSet=\"1\"").Write(Directory);
+  EXPECT_FALSE(Cached());
+  EXPECT_TRUE(Cached());
+}
+
+TEST_F(ProjectCacheTest, PropertySheetChanged) {
+  EXPECT_FALSE(Cached());
+  Directory.Write("common.vsprops", string(kPropertySheet) + "\n");
+  EXPECT_FALSE(Cached());
+  EXPECT_TRUE(Cached());
+}
+
+TEST_F(ProjectCacheTest, Truncated) {
+  EXPECT_FALSE(Cached());
+  string contents;
+  ASSERT_TRUE(FileToString(CachePath, &contents));
+  Directory.Write("cached.vcproj.cache", contents.substr(0, contents.size() / 2));
+
+  vs::Project project;
+  EXPECT_FALSE(LoadProjectCache(CachePath, ProjectPath, &project));
+  EXPECT_FALSE(Cached());
+  EXPECT_TRUE(Cached());
+}
+
+TEST_F(ProjectCacheTest, Corrupt) {
+  EXPECT_FALSE(Cached());
+  string contents;
+  ASSERT_TRUE(FileToString(CachePath, &contents));
+
+  vs::Project project;
+  Directory.Write("cached.vcproj.cache", string(contents.size(), '\xff'));
+  EXPECT_FALSE(LoadProjectCache(CachePath, ProjectPath, &project));
+
+  // a header that holds up but references past the end of the file
+  string corrupt(contents);
+  for(size_t i = 16; i < corrupt.size(); ++i) corrupt[i] = '\x7f';
+  Directory.Write("cached.vcproj.cache", corrupt);
+  EXPECT_FALSE(LoadProjectCache(CachePath, ProjectPath, &project));
+  EXPECT_FALSE(Cached());
+}
+
+} //namespace
+#endif
@@ -17,6 +17,15 @@
     //
     virtual bool Parse(const std::string& path) = 0;
 
+    // Initializes the parser from the in memory contents of the
+    // project file located at path. path is still used to resolve
+    // relative paths and property sheets.
+    //
+    // @path: location of the project file
+    // @buffer: contents of the project file
+    // @len: byte length of buffer
+    virtual bool Parse(const std::string& path, const char* buffer, size_t len) = 0;
+
 
     // Collect global project properties
     //
@@ -0,0 +1,212 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+#include <stdlib.h>
+#include <stdio.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "libvs.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Directory for the files of a test, created under TMPDIR (TEMP on
+// Windows) and removed with everything in it on destruction.
+struct TempDirectory {
+  TempDirectory() {
+#ifdef _WIN32
+    const char* root = getenv("TEMP");
+    path.assign(root ? root : ".");
+    path.append("\\vstomake_test.XXXXXX");
+    if(_mktemp_s(&path[0], path.size() + 1) != 0 || _mkdir(path.c_str()) != 0) {
+      path.clear();
+    }
+#else
+    const char* root = getenv("TMPDIR");
+    path.assign(root ? root : "/tmp");
+    path.append("/vstomake_test.XXXXXX");
+    if(!mkdtemp(&path[0])) path.clear();
+#endif
+  }
+
+  ~TempDirectory() {
+    if(!path.empty()) Remove(path);
+  }
+
+  // Returns the location of name inside the directory
+  std::string Path(const std::string& name) const {
+    return path + "/" + name;
+  }
+
+  // Creates the directory name inside the directory.
+  //
+  // Returns its location
+  std::string MakeDirectory(const std::string& name) const {
+#ifdef _WIN32
+    _mkdir(Path(name).c_str());
+#else
+    mkdir(Path(name).c_str(), 0777);
+#endif
+    return Path(name);
+  }
+
+  // Writes contents to name inside the directory.
+  //
+  // Returns the location of the file
+  std::string Write(const std::string& name, const std::string& contents) const {
+    std::ofstream fs(Path(name).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    fs << contents;
+    return Path(name);
+  }
+
+  std::string path;
+
+ private:
+  static void Remove(const std::string& directory) {
+#ifdef _WIN32
+    _finddata_t entry;
+    intptr_t find = _findfirst((directory + "\\*").c_str(), &entry);
+    if(find != -1) {
+      do {
+        std::string name(entry.name);
+        if(name == "." || name == "..") continue;
+        if(entry.attrib & _A_SUBDIR) {
+          Remove(directory + "\\" + name);
+        } else {
+          remove((directory + "\\" + name).c_str());
+        }
+      } while(_findnext(find, &entry) == 0);
+      _findclose(find);
+    }
+    _rmdir(directory.c_str());
+#else
+    if(DIR* dir = opendir(directory.c_str())) {
+      while(dirent* entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if(name == "." || name == "..") continue;
+
+        struct stat info;
+        std::string child(directory + "/" + name);
+        if(lstat(child.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+          Remove(child);
+        } else {
+          unlink(child.c_str());
+        }
+      }
+      closedir(dir);
+    }
+    rmdir(directory.c_str());
+#endif
+  }
+
+  TempDirectory(const TempDirectory&);
+  TempDirectory& operator=(const TempDirectory&);
+};
+
+// Text of a .vcproj for a test with a Win32 platform and the
+// configurations, tools and files added to it. Parsing detects the
+// format from the file on disk, which takes at least one File.
+//
+// usage pattern:
+// TestProject project("flags");
+// project.Configuration("Release", "WholeProgramOptimization=\"1\"")
+//        .Tool("VCCLCompilerTool", "Optimization=\"2\"")
+//        .File("src/main.cc");
+// ParseTestProject(directory, project, &parsed);
+struct TestProject {
+  explicit TestProject(const std::string& name) : name(name) {}
+
+  // Adds the configuration name|Win32 with the given attributes
+  // besides its name and ConfigurationType="1".
+  TestProject& Configuration(const std::string& name, const std::string& attributes = "") {
+    configurations.push_back(ConfigurationText());
+    configurations.back().open = "    <Configuration Name=\"" + name + "|Win32\" ConfigurationType=\"1\"" +
+                                 (attributes.empty() ? "" : " " + attributes) + ">\n";
+    return *this;
+  }
+
+  // Adds the tool name with the given attributes to the last
+  // configuration.
+  TestProject& Tool(const std::string& name, const std::string& attributes = "") {
+    configurations.back().tools += "      <Tool Name=\"" + name + "\"" +
+                                   (attributes.empty() ? "" : " " + attributes) + "/>\n";
+    return *this;
+  }
+
+  // Adds the file at path, relative to the project and separated by
+  // either slash.
+  TestProject& File(const std::string& path) {
+    std::string relative(".\\" + path);
+    for(size_t i = 0; i < relative.size(); ++i) {
+      if(relative[i] == '/') relative[i] = '\\';
+    }
+    files += "    <File RelativePath=\"" + relative + "\"/>\n";
+    return *this;
+  }
+
+  // Returns the project file's contents
+  std::string str() const {
+    std::string text(
+      "<?xml version=\"1.0\" encoding=\"Windows-1252\"?>\n"
+      "<VisualStudioProject ProjectType=\"Visual C++\" Version=\"9.00\" Name=\"" + name + "\">\n"
+      "  <Platforms><Platform Name=\"Win32\"/></Platforms>\n"
+      "  <Configurations>\n");
+    for(size_t i = 0; i < configurations.size(); ++i) {
+      text += configurations[i].open + configurations[i].tools + "    </Configuration>\n";
+    }
+    text += "  </Configurations>\n"
+            "  <Files>\n" + files + "  </Files>\n"
+            "</VisualStudioProject>\n";
+    return text;
+  }
+
+  // Writes the project to directory as <name>.vcproj.
+  //
+  // Returns the location of the file
+  std::string Write(const TempDirectory& directory) const {
+    return directory.Write(name + ".vcproj", str());
+  }
+
+  std::string name;
+
+ private:
+  struct ConfigurationText {
+    std::string open;
+    std::string tools;
+  };
+  std::vector<ConfigurationText> configurations;
+  std::string files;
+};
+
+// Writes project to directory and parses it.
+//
+// @directory: directory to write the project file to
+// @project:   project to write
+// @parsed:    receives the parsed project
+//
+// Returns the errors of the parse, empty on success
+inline std::string ParseTestProject(const TempDirectory& directory, const TestProject& project,
+                                    vs::Project* parsed) {
+  std::string errors;
+  *parsed = vs::Project();
+  vs::Project::Parse(project.Write(directory), parsed, &errors);
+  return errors;
+}
@@ -0,0 +1,110 @@
+#!/bin/sh
+# Copyright 2012 William Dang.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Measures how long GNU make takes to read and evaluate a generated
+# Makefile for a synthetic project.
+#
+#   testing/benchmark_makefile.sh [vstomake] [files=10000] [directories=100]
+#
+# Generates a two configuration project with empty sources spread over
+# the given number of directories, runs vstomake on it and reports the
+# best of three runs of:
+#   make -n DebugWin32Stats   reading and evaluating one fragment
+#   make -n DebugWin32        the above plus walking every object rule
+#   make -n all               every configuration's fragment
+set -e
+
+VSTOMAKE=${1:-vstomake}
+FILES=${2:-10000}
+DIRECTORIES=${3:-100}
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/vstomake_benchmark.XXXXXX")
+trap 'rm -rf "$WORK"' EXIT
+
+configuration() {
+  cat <<EOF
+		<Configuration
+			Name="$1|Win32"
+			OutputDirectory="bin\\\$(ConfigurationName)"
+			IntermediateDirectory="\$(OutDir)\\obj"
+			ConfigurationType="1"
+			>
+			<Tool
+				Name="VCCLCompilerTool"
+				AdditionalIncludeDirectories="include"
+				PreprocessorDefinitions="WIN32;$2"
+			/>
+			<Tool
+				Name="VCLinkerTool"
+			/>
+		</Configuration>
+EOF
+}
+
+cd "$WORK"
+i=0
+while [ $i -lt "$DIRECTORIES" ]; do
+  mkdir -p "src/dir$i"
+  i=$((i+1))
+done
+
+{
+  cat <<EOF
+<?xml version="1.0" encoding="Windows-1252"?>
+<VisualStudioProject
+	ProjectType="Visual C++"
+	Version="9.00"
+	Name="benchmark"
+	>
+	<Platforms>
+		<Platform
+			Name="Win32"
+		/>
+	</Platforms>
+	<Configurations>
+EOF
+  configuration Debug _DEBUG
+  configuration Release NDEBUG
+  printf '\t</Configurations>\n\t<Files>\n'
+  i=0
+  while [ $i -lt "$FILES" ]; do
+    file="src/dir$((i % DIRECTORIES))/file$i.cc"
+    : > "$file"
+    printf '\t\t<File\n\t\t\tRelativePath=".\\%s"\n\t\t\t>\n\t\t</File>\n' "$(echo "$file" | tr / '\\\\')"
+    i=$((i+1))
+  done
+  printf '\t</Files>\n</VisualStudioProject>\n'
+} > benchmark.vcproj
+
+"$VSTOMAKE" benchmark.vcproj . --no-cache > /dev/null
+
+# best of three wall clock runs in milliseconds
+measure() {
+  best=
+  for run in 1 2 3; do
+    start=$(date +%s%N)
+    make -n "$@" > /dev/null 2>&1 || true
+    end=$(date +%s%N)
+    elapsed=$(( (end - start) / 1000000 ))
+    if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then
+      best=$elapsed
+    fi
+  done
+  printf '%-28s %6d ms\n' "make -n $*" "$best"
+}
+
+echo "$FILES files in $DIRECTORIES directories, $(cat Makefile Makefile.* | wc -c) bytes of Makefile"
+measure DebugWin32Stats
+measure DebugWin32
+measure all
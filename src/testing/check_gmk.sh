@@ -0,0 +1,58 @@
+#!/bin/sh
+# Copyright 2012 William Dang.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Checks that vstomake_gmk.vcproj lists every source its make module needs.
+#
+#   testing/check_gmk.sh [vstomake] [configuration=Debug]
+#
+# Run from src. Generates the Makefiles of vstomake_gmk.vcproj and builds
+# the module refusing undefined symbols, then loads it into make and
+# queries vstomake_gmk.vcproj through it. The gmk_* functions are make's
+# own, so the link resolves them from a stub library; make's definitions
+# take precedence once the module is loaded.
+set -e
+
+VSTOMAKE=${1:-vstomake}
+CONFIGURATION=${2:-Debug}
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/vstomake_gmk.XXXXXX")
+trap 'rm -rf "$WORK"' EXIT
+
+cat > "$WORK/gnumake_stub.c" <<EOF
+#include <gnumake.h>
+
+void gmk_free(char* str) { (void)str; }
+char* gmk_alloc(unsigned int len) { (void)len; return 0; }
+void gmk_eval(const char* buffer, const gmk_floc* floc) { (void)buffer; (void)floc; }
+char* gmk_expand(const char* str) { (void)str; return 0; }
+void gmk_add_function(const char* name, gmk_func_ptr func, unsigned int min_args,
+                      unsigned int max_args, unsigned int flags) {
+  (void)name; (void)func; (void)min_args; (void)max_args; (void)flags;
+}
+EOF
+${CC:-cc} -shared -fPIC "$WORK/gnumake_stub.c" -o "$WORK/libgnumake_stub.so"
+
+"$VSTOMAKE" vstomake_gmk.vcproj "$WORK" > /dev/null
+make -f "$WORK/Makefile" "$CONFIGURATION" LDFLAGS="-Wl,--no-undefined -L$WORK -Wl,-rpath,$WORK" \
+     LDLIBS=-lgnumake_stub
+
+OUTPUTS=$(make -s -f "$WORK/Makefile" "${CONFIGURATION}Win32Stats" | sed -n 's/^Outputs: *//p')
+cat > "$WORK/check.mk" <<EOF
+load $OUTPUTS/libvstomake_gmk.so(vstomake_gmk_setup)
+SOURCES := \$(vs-sources vstomake_gmk.vcproj,$CONFIGURATION|Win32)
+all:
+	@test -n "\$(SOURCES)"
+	@echo "libvstomake_gmk.so: \$(words \$(SOURCES)) sources"
+EOF
+make -s -f "$WORK/check.mk"
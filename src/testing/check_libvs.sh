@@ -0,0 +1,68 @@
+#!/bin/sh
+# Copyright 2012 William Dang.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Checks that libvs.vcproj lists every source its shared library needs.
+#
+#   testing/check_libvs.sh [vstomake] [configuration=DebugShared]
+#
+# Run from src. Generates the Makefiles of libvs.vcproj, builds the
+# shared configuration refusing undefined symbols, then links a C
+# program against libvs.so that parses libvs.vcproj through the C
+# interface and generates its Makefile.
+set -e
+
+VSTOMAKE=${1:-vstomake}
+CONFIGURATION=${2:-DebugShared}
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/vstomake_libvs.XXXXXX")
+trap 'rm -rf "$WORK"' EXIT
+
+"$VSTOMAKE" libvs.vcproj "$WORK" > /dev/null
+make -f "$WORK/Makefile" "$CONFIGURATION" LDFLAGS=-Wl,--no-undefined
+
+cat > "$WORK/check.c" <<EOF
+#include <stdio.h>
+#include "libvs_c.h"
+
+int main(void) {
+  vs_project* project;
+  vs_makefile* makefile;
+  vs_string_view errors;
+  size_t configurations;
+
+  if(vs_api_version() != VS_API_VERSION) {
+    fprintf(stderr, "libvs.so is version %d, expected %d\n", vs_api_version(), VS_API_VERSION);
+    return 1;
+  }
+  project = vs_project_parse("libvs.vcproj", NULL, 0);
+  if(!project) return 1;
+  errors = vs_project_errors(project);
+  configurations = vs_configuration_count(project);
+  if(errors.size || !configurations) {
+    fprintf(stderr, "libvs.vcproj: %.*s\n", (int)errors.size, errors.data);
+    return 1;
+  }
+  makefile = vs_makefile_generate(project, NULL);
+  if(!makefile || !vs_makefile_contents(makefile).size) return 1;
+  printf("libvs.so: %u configurations, %u fragments\n", (unsigned)configurations,
+         (unsigned)vs_makefile_fragment_count(makefile));
+  vs_makefile_free(makefile);
+  vs_project_free(project);
+  return 0;
+}
+EOF
+
+OUTDIR=$(make -s -f "$WORK/Makefile" "${CONFIGURATION}Win32Stats" | sed -n 's/^Outputs: *//p')
+${CC:-cc} -I. "$WORK/check.c" -L"$OUTDIR" -lvs -Wl,-rpath,"$OUTDIR" -o "$WORK/check"
+"$WORK/check"
@@ -29,6 +29,16 @@
 #endif
 
 #include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/locking.h>
+#include <sys/stat.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 std::string AbsoluteFilePath( const std::string& path ){
@@ -43,4 +53,98 @@ std::string AbsoluteFilePath( const std::string& path ){
   unsigned results = realpath(path.c_str(),buffer);
 #endif
   return results ? std::string(buffer) : path;
-}
\ No newline at end of file
+}
+
+bool FileContentsDiffer(const std::string& path, const std::string& contents) {
+  std::string existing("");
+  if(!FileToString(path, &existing)) return true;
+  return existing.size() != contents.size() ||
+         HashString(existing) != HashString(contents);
+}
+
+bool WriteFileIfChanged(const std::string& path, const std::string& contents,
+                        bool* changed) {
+  if(changed) *changed = false;
+  if(!FileContentsDiffer(path, contents)) return true;
+
+  if(!WriteFileAtomically(path, contents.data(), contents.size())) return false;
+  if(changed) *changed = true;
+  return true;
+}
+
+bool WriteFileAtomically(const std::string& path, const char* data, size_t size) {
+  return WriteFileAtomically(path, [data, size](int fd) {
+    const char* bytes = data;
+    size_t count = size;
+    while(count > 0) {
+#ifdef _WIN32
+      int written = _write(fd, bytes, static_cast<unsigned>(count));
+#else
+      ssize_t written = write(fd, bytes, count);
+      if(written == -1 && errno == EINTR) continue;
+#endif
+      if(written <= 0) return false;
+      bytes += written;
+      count -= written;
+    }
+    return true;
+  });
+}
+
+bool WriteFileAtomically(const std::string& path, const std::function<bool(int)>& writer) {
+  std::string temp_path(path + ".XXXXXX");
+#ifdef _WIN32
+  if(_mktemp_s(&temp_path[0], temp_path.size() + 1) != 0) return false;
+  int fd = _open(temp_path.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY,
+                 _S_IREAD | _S_IWRITE);
+#else
+  // mkstemp creates the file readable by its owner only
+  int fd = mkstemp(&temp_path[0]);
+  if(fd != -1) {
+    mode_t mask = umask(0);
+    umask(mask);
+    fchmod(fd, 0666 & ~mask);
+  }
+#endif
+  if(fd == -1) return false;
+
+  bool written = writer(fd);
+#ifdef _WIN32
+  written = _close(fd) == 0 && written;
+  if(written) remove(path.c_str());
+#else
+  written = close(fd) == 0 && written;
+#endif
+
+  if(!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+FileLock::FileLock(const std::string& path, bool wait) : fd(-1) {
+#ifdef _WIN32
+  fd = _open(path.c_str(), _O_RDWR | _O_CREAT, _S_IREAD | _S_IWRITE);
+  if(fd != -1 && _locking(fd, wait ? _LK_LOCK : _LK_NBLCK, 1) != 0) {
+    _close(fd);
+    fd = -1;
+  }
+#else
+  fd = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+  if(fd != -1 && flock(fd, wait ? LOCK_EX : LOCK_EX | LOCK_NB) != 0) {
+    close(fd);
+    fd = -1;
+  }
+#endif
+}
+
+FileLock::~FileLock() {
+  if(fd == -1) return;
+#ifdef _WIN32
+  _locking(fd, _LK_UNLCK, 1);
+  _close(fd);
+#else
+  close(fd);
+#endif
+}
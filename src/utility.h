@@ -14,6 +14,7 @@
 #pragma once
 
 #include <fstream>
+#include <functional>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -120,6 +121,90 @@ inline std::string FileToString(const std::string& path){
 // string as an absolute file path 
 std::string AbsoluteFilePath(const std::string& path);
 
+// 64-bit FNV-1a hash of the given bytes.
+//
+// @data: bytes to hash
+// @len: byte length of data
+// @seed: result of a previous call when hashing
+//        discontiguous data
+inline uint64_t HashBytes(const char* data, size_t len,
+                          uint64_t seed = 14695981039346656037ULL) {
+  uint64_t hash = seed;
+  for(size_t i = 0; i < len; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+inline uint64_t HashString(const std::string& str,
+                           uint64_t seed = 14695981039346656037ULL) {
+  return HashBytes(str.data(), str.size(), seed);
+}
+
+// Hashes the contents of the file located at path.
+//
+// Returns true on success
+inline bool HashFile(const std::string& path, uint64_t* hash) {
+  std::string buffer("");
+  if(!FileToString(path, &buffer)) return false;
+  *hash = HashString(buffer);
+  return true;
+}
+
+// Returns true if the file at path is missing or its
+// contents differ from the given contents
+bool FileContentsDiffer(const std::string& path, const std::string& contents);
+
+// Replace the file at path with the given contents. The contents
+// are written to a uniquely named temporary file beside path that is
+// renamed over it, so readers never observe a partially written file
+// and concurrent writers never share a temporary file.
+//
+// @path: location of the file
+// @data: new contents of the file
+// @size: byte length of data
+//
+// Returns true on success
+bool WriteFileAtomically(const std::string& path, const char* data, size_t size);
+
+// Same as above for contents written by a callback to the temporary
+// file's descriptor, such as an OutputBuffer's WriteTo.
+//
+// @path: location of the file
+// @writer: writes the new contents to the descriptor it is given,
+//         returns false on failure
+//
+// Returns true on success
+bool WriteFileAtomically(const std::string& path, const std::function<bool(int fd)>& writer);
+
+// Replace the file at path with the given contents unless it
+// already holds them, leaving its modification time untouched.
+// See WriteFileAtomically.
+//
+// @path: location of the file
+// @contents: new contents of the file
+// @changed: optional, set to true if the file was written
+//
+// Returns true on success
+bool WriteFileIfChanged(const std::string& path, const std::string& contents,
+                        bool* changed = 0);
+
+// Exclusive lock on a file held for the lifetime of the object
+struct FileLock {
+  // @path: location of the lock file, created if missing
+  // @wait: block until the lock is available rather than fail
+  explicit FileLock(const std::string& path, bool wait = true);
+  ~FileLock();
+
+  bool locked() const { return fd != -1; }
+
+ private:
+  FileLock(const FileLock&);
+  FileLock& operator=(const FileLock&);
+  int fd;
+};
+
 
 
 
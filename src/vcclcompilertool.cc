@@ -17,6 +17,11 @@ VCCLCompilerTool::VCCLCompilerTool(){}
 
 // VCCLCompilerTool's members is implemented via excessive X-macros
 // since their functionality simply queries the underlying property map
+//
+// Enum properties hold the number Visual Studio writes, which is the
+// value of the matching enumerator: Optimization="2" is optimizeMaxSpeed
+// and UsePrecompiledHeader="2" pchUseUsingSpecific. DebugInformationFormat
+// has no value 2, so /Zi (3) and /ZI (4) are moved down by one.
 #define VCCLCOMPILERTOOL_ENUM_ACCESSORS X(AssemblerOutput, asmListingOption, 5)\
 X(BasicRuntimeChecks, basicRuntimeCheckOption, 4)\
 X(BrowseInformation, browseInfoOption, 3)\
@@ -41,7 +46,7 @@ X(FloatingPointModel, floatingPointModel, 3)
     auto iter = properties->find(# NAME);                                                \
     VCCLCompilerTool::Enum::TYPE rv = (VCCLCompilerTool::Enum::TYPE)0;                   \
     if (iter != properties->end()) {                                                     \
-      int offset = strtol(iter->second.c_str(), 0, 10) + 1;                              \
+      int offset = strtol(iter->second.c_str(), 0, 10);                                  \
       if(strcmp(#NAME,"DebugInformationFormat") ==0 && offset >= 3)                      \
         --offset;                                                                        \
       rv = static_cast<VCCLCompilerTool::Enum::TYPE>(offset);                            \
@@ -126,4 +131,8 @@ X(toolName)
 
 VCCLCOMPILERTOOL_STRING_ACCESSORS
 #undef X
+
+bool VCCLCompilerTool::HasProperty(const char* name) const {
+  return properties->find(name) != properties->end();
+}
 }
@@ -221,6 +221,10 @@ struct VCCLCompilerTool {
   bool                             WholeProgramOptimization() const;
   const char*                      XMLDocumentationFileName() const;
 
+  // Returns true if the project sets the property. The accessors
+  // can't tell an unset property from one set to false or zero.
+  bool                             HasProperty(const char* name) const;
+
 
 private:
   friend struct Project;
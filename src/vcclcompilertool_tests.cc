@@ -0,0 +1,41 @@
+#ifdef VSTOMAKE_RUN_TESTS
+#include "vcclcompilertool.h"
+#include <gtest/gtest.h>
+#include "libvs.h"
+
+namespace {
+using std::string;
+typedef vs::VCCLCompilerTool::Enum CL;
+
+// Debug and Release configurations as Visual Studio writes them
+const char kCheckProject[] = "testing/vcclcompilertool_check/vcclcompilertool_check.vcproj";
+
+// The enum accessors map the number Visual Studio writes straight to
+// the enumerator of the same value, DebugInformationFormat skipping
+// the unused value 2.
+TEST(VCCLCompilerToolTest, EnumAccessors) {
+  vs::Project project;
+  string status;
+  vs::Project::Parse(kCheckProject, &project, &status);
+  EXPECT_EQ(status, "");
+  ASSERT_EQ(project.Configurations.size(), 2);
+  const vs::VCCLCompilerTool& debug = project.Configurations[0].CLCompilerTool;
+  const vs::VCCLCompilerTool& release = project.Configurations[1].CLCompilerTool;
+  ASSERT_EQ(project.Configurations[0].ConfigurationName, "Debug");
+  ASSERT_EQ(project.Configurations[1].ConfigurationName, "Release");
+
+  // Optimization="0" and "2"
+  EXPECT_EQ(debug.Optimization(), CL::optimizeDisabled);
+  EXPECT_EQ(release.Optimization(), CL::optimizeMaxSpeed);
+
+  // DebugInformationFormat="4" (/ZI) and "3" (/Zi)
+  EXPECT_EQ(debug.DebugInformationFormat(), CL::debugEditAndContinue);
+  EXPECT_EQ(release.DebugInformationFormat(), CL::debugEnabled);
+
+  // UsePrecompiledHeader="2" (/Yu)
+  EXPECT_EQ(debug.UsePrecompiledHeader(), CL::pchUseUsingSpecific);
+  EXPECT_EQ(release.UsePrecompiledHeader(), CL::pchUseUsingSpecific);
+}
+
+} //namespace
+#endif
@@ -26,7 +26,6 @@ X(ErrorReporting)\
 X(FixedBaseAddress)\
 X(LargeAddressAware)\
 X(LinkIncremental)\
-X(LinkTimeCodeGeneration)\
 X(OptimizeForWindows98)\
 X(OptimizeReferences)\
 X(ShowProgress)\
@@ -48,6 +47,20 @@ X(driver)
 VCLINKERTOOL_ENUM_ACCESSORS
 #undef X
 
+// .vcproj files store the option's value, MSBuild its name
+VCLinkerTool::Enum VCLinkerTool::LinkTimeCodeGeneration() const {
+  auto iter = properties->find("LinkTimeCodeGeneration");
+  if(iter == properties->end()) return Enum_Unknown;
+
+  const std::string& value = iter->second;
+  if(value == "0" || value == "Default")                   return Enum_LinkTimeCodeGenerationOptionDefault;
+  if(value == "1" || value == "UseLinkTimeCodeGeneration") return Enum_LinkTimeCodeGenerationOptionUse;
+  if(value == "2" || value == "PGInstrument")              return Enum_LinkTimeCodeGenerationOptionInstrument;
+  if(value == "3" || value == "PGOptimization")            return Enum_LinkTimeCodeGenerationOptionOptimize;
+  if(value == "4" || value == "PGUpdate")                  return Enum_LinkTimeCodeGenerationOptionUpdate;
+  return Enum_Unknown;
+}
+
 
 
 
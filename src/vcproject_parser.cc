@@ -265,6 +265,7 @@ bool VCProjectParser::Configurations(vector<vs::Configuration>* configurations)
     string property_sheets("");
 
     vs::Configuration config;
+    config.WholeProgramOptimization = vs::Enum::Optimization_None;
 
     if(XMLAttribute* attr = node->first_attribute("Name")) {
       config.Name.assign(attr->value());
@@ -299,6 +300,10 @@ bool VCProjectParser::Configurations(vector<vs::Configuration>* configurations)
       
     }
 
+    if(XMLAttribute* attr = node->first_attribute("WholeProgramOptimization")) {
+      config.WholeProgramOptimization = (vs::Enum::Optimization)strtol(attr->value(), 0, 10);
+    }
+
 
     // Collect tool properties
     CollectToolProperties(node->first_node("Tool"), config.ToolProperties, macros);
@@ -391,6 +396,7 @@ bool VCProjectParser::Files(vector<vs::Configuration>* configurations, vector<vs
     vs::File file;
     file.Precompiled = false;
     file.CompileAsC = false;
+    file.ToolOverrides = false;
     file.ForcedInclude = false;
     
     // build a list of configurations that will
@@ -424,9 +430,13 @@ bool VCProjectParser::Files(vector<vs::Configuration>* configurations, vector<vs
       // Precompiled only describes the source file (.cpp,cc, etc)
       // that created the compiled header(.pch)
       if(const XMLNode* tool = file_configuration->first_node("Tool")) {
+        // any property besides the tool's name
+        for(const XMLAttribute* prop = tool->first_attribute(); prop; prop = prop->next_attribute()) {
+          if(strcmp(prop->name(), "Name") != 0) file.ToolOverrides = true;
+        }
 
-        if(tool->first_attribute("UsePrecompiledHeader")) {
-          file.Precompiled = true;
+        if(const XMLAttribute* pch = tool->first_attribute("UsePrecompiledHeader")) {
+          file.Precompiled = strcmp(pch->value(), "1") == 0;
         }
 
         if(const XMLAttribute* compile_as_c = tool->first_attribute("CompileAs")) {
@@ -489,6 +499,7 @@ bool VCProjectParser::Files(std::vector<vs::File>* files) {
     vs::File file;
     file.Precompiled = false;
     file.CompileAsC = false;
+    file.ToolOverrides = false;
     file.ForcedInclude = false;
     
 
@@ -523,7 +534,13 @@ bool VCProjectParser::Files(std::vector<vs::File>* files) {
       // Precompiled only describes the source file (.cpp,cc, etc)
       // that created the compiled header(.pch)
       if(const XMLNode* tool = file_configuration->first_node("Tool")) {
-        file.Precompiled = tool->first_attribute("UsePrecompiledHeader") != 0;
+        // any property besides the tool's name
+        for(const XMLAttribute* prop = tool->first_attribute(); prop; prop = prop->next_attribute()) {
+          if(strcmp(prop->name(), "Name") != 0) file.ToolOverrides = true;
+        }
+        if(const XMLAttribute* pch = tool->first_attribute("UsePrecompiledHeader")) {
+          file.Precompiled = strcmp(pch->value(), "1") == 0;
+        }
 
         if(const XMLAttribute* compile_as_c = tool->first_attribute("CompileAs")) {
           file.CompileAsC = strcmp(compile_as_c->value(), "1") == 0;
@@ -573,9 +590,13 @@ bool VCProjectParser::Parse(char* buffer, size_t len) {
 }
 
 bool VCProjectParser::Parse(const std::string& path) {
-  origin.assign(path);
   string buffer("");
   FileToString(path, &buffer);
+  return Parse(path, buffer.data(), buffer.length());
+}
+
+bool VCProjectParser::Parse(const std::string& path, const char* buffer, size_t len) {
+  origin.assign(path);
   root = 0;
   macros.clear();
   for(size_t i = 0; i < ARRAY_COUNT(kProjectMacros2008); ++i) {
@@ -585,8 +606,8 @@ bool VCProjectParser::Parse(const std::string& path) {
   macros["$(ProjectDir)"].assign(path);
 
   src.clear();
-  src.reserve(buffer.length());
-  copy(buffer.begin(), buffer.end(), back_inserter(src));
+  src.reserve(len + 1);
+  copy(buffer, buffer + len, back_inserter(src));
   src.push_back('\0');
 
   doc.parse<0>(&src[0]);
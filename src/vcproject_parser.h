@@ -25,6 +25,7 @@ struct VCProjectParser : public ProjectParser {
   
   virtual bool Parse(char* buffer, size_t len);
   virtual bool Parse(const std::string& path);
+  virtual bool Parse(const std::string& path, const char* buffer, size_t len);
   
   virtual bool ProjectProperties(std::unordered_map<std::string, std::string>* props);
 
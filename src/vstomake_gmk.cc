@@ -0,0 +1,98 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// GNU make (4.0 or later) loadable module exposing the output options
+// as make functions, so Makefiles can query projects without spawning
+// vstomake through $(shell ...):
+//
+//   load libvstomake_gmk.so(vstomake_gmk_setup)
+//   CPPFLAGS += $(vs-defines proj.vcproj,Release|Win32)
+//   SRCS     := $(vs-sources proj.vcproj,Release|Win32)
+//
+// Each function takes a project path, a configuration name (or -a for
+// every configuration) and an optional prefix which may contain any of
+// the macros listed in vstomake's [macros] documentation. Projects are
+// parsed once and kept in memory for the lifetime of the make process.
+#include "precompiled.h"
+#include "output_option.h"
+
+extern "C" {
+#include <gnumake.h>
+}
+
+using std::string;
+
+// required by GNU make before it will load the module
+extern "C" int plugin_is_GPL_compatible;
+int plugin_is_GPL_compatible;
+
+namespace {
+
+// make function names and the output option each one expands
+const struct {
+  const char* name;
+  const char* option;
+} kFunctions[] = {
+  {"vs-forced-includes", "-i"},
+  {"vs-includes",        "-I"},
+  {"vs-libraries",       "-l"},
+  {"vs-library-dirs",    "-L"},
+  {"vs-defines",         "-D"},
+  {"vs-sources",         "-s"},
+};
+
+// Projects parsed by this make process. The on-disk cache is
+// shared with the vstomake executable.
+ProjectQueries& Queries() {
+  static ProjectQueries queries(true);
+  return queries;
+}
+
+// Returns the trimmed argument since make passes
+// the text following each comma verbatim
+string Argument(const char* arg) {
+  string value(arg);
+  size_t begin = value.find_first_not_of(" \t");
+  size_t end   = value.find_last_not_of(" \t");
+  return begin == string::npos ? string("") : value.substr(begin, end-begin+1);
+}
+
+char* ExpandOption(const char* name, unsigned int argc, char** argv) {
+  const char* option = 0;
+  foreach(auto& f, kFunctions) {
+    if(strcmp(f.name, name) == 0) option = f.option;
+  }
+  if(!option) return 0;
+
+  string prefix(argc > 2 ? argv[2] : "");
+  string answer;
+  if(!Queries().Answer(Argument(argv[0]), Argument(argv[1]), option, prefix, &answer)) {
+    fprintf(stderr, "%s: %s\n", name, answer.c_str());
+    return 0;
+  }
+
+  char* result = gmk_alloc(answer.size() + 1);
+  memcpy(result, answer.c_str(), answer.size() + 1);
+  return result;
+}
+
+} // namespace
+
+// Called by make's load directive
+extern "C" int vstomake_gmk_setup(const gmk_floc*) {
+  foreach(auto& f, kFunctions) {
+    gmk_add_function(f.name, ExpandOption, 2, 3, GMK_FUNC_DEFAULT);
+  }
+  return 1;
+}
@@ -17,10 +17,16 @@
 #include <sys/stat.h>
 #include <vector>
 #include <unordered_map>
+#include <iostream>
 
+#include "deplog.h"
+#include "include_analysis.h"
+#include "local_jobs.h"
 #include "make_file.h"
 #include "libvs.h"
 #include "output_option.h"
+#include "project_cache.h"
+#include "watch.h"
 #include "utility.h"
 
 using std::string;
@@ -34,9 +40,18 @@ using std::make_pair;
 // @@ kDocumentation
 static const char kDocumentation[] ="\
 Makefile generation:\n\
-  vstomake [input] [directory=./]\n\
+  vstomake [input] [directory=./] [flags]\n\
 Console output:\n\
-  vstomake [input] [option] [configuration name]\n\
+  vstomake [input] [option] [configuration name] [flags]\n\
+Batch console output:\n\
+  vstomake --query [flags]\n\
+Dependency database update:\n\
+  vstomake --deplog [database] [dependency file]\n\
+  vstomake --deplog [database]\n\
+Local job:\n\
+  vstomake --local [jobs] [lock prefix] -- [command]\n\
+Include analysis:\n\
+  vstomake [input] --analyze-includes[=directory] [configuration name]\n\
 \n\
   [input]\n\
     A vcproj file\n\
@@ -57,7 +72,7 @@ Console output:\n\
     Example:\n\
       vstomake vstomake.vcproj -D=\"$(CPPFLAGS) =\" \"Debug|Win32\"\n\
     Output:\n\
-      $(CPPFLAGS) =-DWIN32 -D_DEBUG -D_CONSOLE -DVSTOMAKE_RUN_TESTS -DRAPIDXML_NO_EXCEPTIONS\n\
+      $(CPPFLAGS) =-DWIN32 -D_DEBUG -D_CONSOLE -DVSTOMAKE_RUN_TESTS\n\
   \n\
     -a           output for all configurations\n\
     -i           forced include files \n\
@@ -77,6 +92,57 @@ Console output:\n\
     $(IntDir)        configuration's intermediate directory\n\
     $(OutDir)        configuration's output directory\n\
     $(Target)        configuration's target output name\n\
+  \n\
+  [flags]\n\
+    --analyze-includes\n\
+                 scan the sources of the given configuration, or of\n\
+                 every configuration if none or -a is given, report the\n\
+                 headers they include by fan-in and size and suggest a\n\
+                 precompiled header. If a directory is given the\n\
+                 suggestion is written there as [configuration]\n\
+                 [platform]_pch.h\n\
+    --check      write nothing; list the files regeneration would change\n\
+                 and exit with a non-zero status if there are any\n\
+    --depdb      generate rules that merge each object's dependencies\n\
+                 into one database per configuration, [intdir]/deps.mk,\n\
+                 using --deplog rather than including a .d file per\n\
+                 object. vstomake must be available when building.\n\
+    --deplog     log a dependency file written by the compiler for a\n\
+                 dependency database, then remove it. Without a\n\
+                 dependency file, merge the logged files into the\n\
+                 database\n\
+    --distcc     compile through distcc, or through icecc with --icecc.\n\
+                 Precompiled headers, links and archives run on this\n\
+                 machine through --local, at most LOCAL_JOBS at once\n\
+                 (the number of processors by default) whatever -j is.\n\
+                 For pump mode run make through pump.\n\
+    --icecc      see --distcc\n\
+    --launcher=command\n\
+                 run compiles through a compiler cache such as ccache\n\
+                 or sccache, with command lines that don't depend on\n\
+                 where the project is checked out. make CXX_LAUNCHER=\n\
+                 overrides it.\n\
+    --local      run a command once one of [jobs] slots shared by every\n\
+                 command given the same lock prefix is free\n\
+    --no-cache   neither read nor write the parsed project cache\n\
+                 ([input].cache)\n\
+    --query      read one query per line from stdin in the form\n\
+                 [input]<TAB>[configuration name]<TAB>[option]\n\
+                 and answer each with one line on stdout. -a may be\n\
+                 given as the configuration name. Projects are kept\n\
+                 in memory between queries.\n\
+    --unity-files=N\n\
+                 compile the sources of each directory in unity\n\
+                 translation units of up to N sources\n\
+    --unity-bytes=N\n\
+                 close a unity translation unit before it would\n\
+                 exceed N bytes of sources\n\
+    --unity-exclude=name[,name]\n\
+                 compile the named sources on their own. Sources with\n\
+                 per-file settings, C sources and the source creating\n\
+                 the precompiled header always are.\n\
+    --watch      keep running and regenerate the Makefile whenever the\n\
+                 project or one of its property sheets changes\n\
   \n";
 
 int ErrorMessage(const string& msg) {
@@ -85,8 +151,66 @@ int ErrorMessage(const string& msg) {
   return 1;
 }
 
+// Removes all arguments of the form --flag[=value] from argv
+// and collects them into flags. Arguments following a lone --
+// are kept as they are.
+//
+// Returns the number of remaining arguments
+static int ParseFlags(int argc, char* argv[], unordered_map<string, string>* flags) {
+  int count = 0;
+  for(int i = 0; i < argc; ++i) {
+    if(strcmp(argv[i], "--") == 0) {
+      while(++i < argc) argv[count++] = argv[i];
+      break;
+    }
+    if(strncmp(argv[i], "--", 2) == 0) {
+      string flag(argv[i]);
+      size_t index = flag.find('=');
+      if(index != string::npos) {
+        flags->insert(make_pair(flag.substr(0, index), flag.substr(index+1)));
+      } else {
+        flags->insert(make_pair(flag, ""));
+      }
+    } else {
+      argv[count++] = argv[i];
+    }
+  }
+  return count;
+}
+
 int main(int argc, char* argv[]) {
-  vector<string> args(argv, argv+argc);
+  unordered_map<string, string> flags;
+  argc = ParseFlags(argc, argv, &flags);
+  bool use_cache = flags.find("--no-cache") == flags.end();
+  bool watch = flags.find("--watch") != flags.end();
+  bool check = flags.find("--check") != flags.end();
+
+  if(flags.find("--query") != flags.end()) {
+    DoQueryMode(use_cache, std::cin, std::cout);
+    return 0;
+  }
+
+  if(flags.find("--deplog") != flags.end()) {
+    if(argc != 2 && argc != 3) {
+      return ErrorMessage("--deplog expects a database and an optional dependency file.");
+    }
+    string error;
+    bool merged = argc == 3 ? AppendDependencyFile(argv[1], argv[2], &error)
+                            : CompactDependencyDatabase(argv[1], &error);
+    if(!merged) {
+      fprintf(stderr, "vstomake: %s\n", error.c_str());
+      return 1;
+    }
+    return 0;
+  }
+
+  if(flags.find("--local") != flags.end()) {
+    if(argc < 4) {
+      return ErrorMessage("--local expects a job count, a lock prefix and a command.");
+    }
+    argv[argc] = 0;
+    return RunLocalJob(atoi(argv[1]), argv[2], argv + 3);
+  }
 
   if(argc < 2) {
     return ErrorMessage("No input files.");
@@ -118,6 +242,20 @@ int main(int argc, char* argv[]) {
     return ErrorMessage(err);
   }
 
+  if(flags.find("--analyze-includes") != flags.end()) {
+    string errors;
+    vs::Project project;
+    if(use_cache) {
+      ParseProjectCached(argv[1], &project, &errors);
+    } else {
+      vs::Project::Parse(argv[1], &project, &errors);
+    }
+    if(!errors.empty()) {
+      return ErrorMessage(errors);
+    }
+    return DoAnalyzeIncludes(project, argc > 2 ? argv[2] : "-a", flags["--analyze-includes"]);
+  }
+
   // check output destination
   memset(&info,0,sizeof (info));
   if(stat(destination.c_str(), &info) ==0) {
@@ -135,9 +273,30 @@ int main(int argc, char* argv[]) {
 
 
 
+  // the generated Makefile reruns vstomake with the same flags
+  MakefileOptions options;
+  foreach(auto& flag, flags) {
+    if(flag.first == "--watch" || flag.first == "--check") continue;
+    options.flags.push_back(flag.second.empty() ? flag.first : flag.first + "=" + flag.second);
+  }
+  std::sort(options.flags.begin(), options.flags.end());
+
+  if(watch && !output_option) {
+    return WatchProject(argv[1], AbsoluteFilePath(destination), options, use_cache);
+  }
+
   string errors;
   vs::Project project;
-  vs::Project::Parse(argv[1], &project, &errors);
+  if(check) {
+    // leave the cache alone as well
+    if(!use_cache || !LoadProjectCache(ProjectCachePath(argv[1]), argv[1], &project)) {
+      vs::Project::Parse(argv[1], &project, &errors);
+    }
+  } else if(use_cache) {
+    ParseProjectCached(argv[1], &project, &errors);
+  } else {
+    vs::Project::Parse(argv[1], &project, &errors);
+  }
 
   if(!errors.empty()) {
     return ErrorMessage(errors);
@@ -147,15 +306,33 @@ int main(int argc, char* argv[]) {
   if(output_option) {
     DoOutputOption(project, argc, argv);
   } else {
-    Makefile makefile(project);
-
-    // write the file
+    // write the file and any configuration fragments
+    // whose inputs changed since the last run
     destination.assign(AbsoluteFilePath(destination));
-    ofstream outfile(destination.c_str());
-    if(outfile.is_open()) {
-      outfile << makefile.contents;
-      outfile.close();
-      printf("Output: %s\n", destination.c_str());
+    Makefile makefile(project, destination, options);
+
+    if(check) {
+      vector<string> changed;
+      if(makefile.Check(destination, &changed)) {
+        foreach(auto& path, changed) {
+          printf("Out of date: %s\n", path.c_str());
+        }
+        fflush(stdout);
+        return 1;
+      }
+      printf("Up to date: %s\n", destination.c_str());
+      fflush(stdout);
+      return 0;
+    }
+
+    vector<string> written;
+    if(makefile.Write(destination, &written)) {
+      foreach(auto& path, written) {
+        printf("Output: %s\n", path.c_str());
+      }
+      if(written.empty()) {
+        printf("Up to date: %s\n", destination.c_str());
+      }
     } else {
       return ErrorMessage("Error writing Makefile");
     }
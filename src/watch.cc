@@ -0,0 +1,188 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "precompiled.h"
+#include "watch.h"
+#include "libvs.h"
+#include "make_file.h"
+#include "project_cache.h"
+#include "utility.h"
+
+#include <map>
+#include <set>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Time to wait for further events after a change so that
+// a save touching several files regenerates only once
+const int kSettleMilliseconds = 50;
+
+// A parsed project and the files it was parsed from
+struct WatchedProject {
+  vs::Project project;
+
+  // absolute path of each input and the hash of its contents
+  map<string, uint64_t> inputs;
+};
+
+bool Load(const string& path, bool use_cache, WatchedProject* watched) {
+  string errors;
+  vs::Project project;
+  if(use_cache) {
+    ParseProjectCached(path, &project, &errors);
+  } else {
+    vs::Project::Parse(path, &project, &errors);
+  }
+
+  if(!errors.empty()) {
+    fprintf(stderr, "%s\n", errors.c_str());
+    return false;
+  }
+
+  watched->inputs.clear();
+  uint64_t hash = 0;
+  HashFile(path, &hash);
+  watched->inputs[AbsoluteFilePath(path)] = hash;
+  foreach(auto& config, project.Configurations) {
+    foreach(auto& sheet, config.PropertySheets) {
+      hash = 0;
+      HashFile(sheet, &hash);
+      watched->inputs[sheet] = hash;
+    }
+  }
+  watched->project = std::move(project);
+  return true;
+}
+
+// Returns true if the contents of any input differ from
+// the contents the project was parsed from
+bool Changed(const WatchedProject& watched) {
+  foreach(auto& input, watched.inputs) {
+    uint64_t hash = 0;
+    HashFile(input.first, &hash);
+    if(hash != input.second) return true;
+  }
+  return false;
+}
+
+void Generate(const WatchedProject& watched, const string& destination,
+              const MakefileOptions& options) {
+  Makefile makefile(watched.project, destination, options);
+  vector<string> written;
+  if(!makefile.Write(destination, &written)) {
+    fprintf(stderr, "Error writing %s\n", destination.c_str());
+    return;
+  }
+  foreach(auto& path, written) {
+    printf("Output: %s\n", path.c_str());
+  }
+  fflush(stdout);
+}
+
+} // namespace
+
+#ifdef __linux__
+int WatchProject(const string& path, const string& destination,
+                 const MakefileOptions& options, bool use_cache) {
+  WatchedProject watched;
+  if(!Load(path, use_cache, &watched)) return 1;
+  Generate(watched, destination, options);
+
+  int fd = inotify_init();
+  if(fd == -1) {
+    perror("inotify_init");
+    return 1;
+  }
+
+  // directories are watched rather than the files themselves
+  // since editors commonly save by replacing the file
+  map<int, string> directories;
+  set<string> watched_directories;
+  printf("Watching %s\n", path.c_str());
+  fflush(stdout);
+  for(;;) {
+    foreach(auto& input, watched.inputs) {
+      string directory(input.first.substr(0, input.first.find_last_of('/')));
+      if(!watched_directories.insert(directory).second) continue;
+
+      int wd = inotify_add_watch(fd, directory.c_str(),
+                                 IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+      if(wd == -1) {
+        perror(directory.c_str());
+        continue;
+      }
+      directories[wd] = directory;
+    }
+
+    // wait until one of the inputs is touched, then until
+    // the events settle
+    bool touched = false;
+    int timeout  = -1;
+    for(;;) {
+      struct pollfd pfd = {fd, POLLIN, 0};
+      int ready = poll(&pfd, 1, timeout);
+      if(ready == -1) {
+        perror("poll");
+        return 1;
+      }
+      if(ready == 0) break;
+
+      char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+      ssize_t len = read(fd, buffer, sizeof(buffer));
+      if(len <= 0) {
+        perror("read");
+        return 1;
+      }
+
+      for(char* ptr = buffer; ptr < buffer + len;) {
+        const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+        ptr += sizeof(struct inotify_event) + event->len;
+
+        auto directory = directories.find(event->wd);
+        if(directory == directories.end() || !event->len) continue;
+
+        string file(directory->second + "/" + event->name);
+        if(watched.inputs.find(file) != watched.inputs.end()) {
+          touched = true;
+        }
+      }
+      if(touched) timeout = kSettleMilliseconds;
+    }
+
+    if(!Changed(watched)) continue;
+
+    WatchedProject reloaded;
+    if(Load(path, use_cache, &reloaded)) {
+      watched.project = std::move(reloaded.project);
+      watched.inputs  = std::move(reloaded.inputs);
+      Generate(watched, destination, options);
+    }
+  }
+}
+#else
+int WatchProject(const string&, const string&, const MakefileOptions&, bool) {
+  fprintf(stderr, "--watch is only supported on Linux\n");
+  return 1;
+}
+#endif
@@ -0,0 +1,33 @@
+// Copyright 2012 William Dang.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+#include <string>
+
+struct MakefileOptions;
+
+// Keeps the Makefile for a project up to date until interrupted.
+//
+// The project is parsed once and kept in memory. The project file and
+// every property sheet it inherits are watched (inotify on Linux); when
+// the contents of one of them change the project is parsed again and
+// only the Makefile fragments whose inputs changed are rewritten.
+//
+// @path         location of the project file
+// @destination  location of the Makefile
+// @options      generation settings
+// @use_cache    read and refresh the parsed project cache
+//
+// Returns a non-zero exit code on error, otherwise does not return.
+int WatchProject(const std::string& path, const std::string& destination,
+                 const MakefileOptions& options, bool use_cache);